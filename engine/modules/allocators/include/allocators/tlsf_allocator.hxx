@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace de::allocators
+{
+	// Two-Level Segregated Fit allocator over abstract offset range [0, size).
+	// Never touches memory it manages, so it could be used for gpu buffers and memory.
+	// Allocation and free are O(1), block headers kept in separate array.
+	class tlsf_allocator final
+	{
+	public:
+		using size_type = uint64_t;
+
+		static constexpr size_type invalid_offset = UINT64_MAX;
+
+		struct allocation
+		{
+			size_type _offset{invalid_offset};
+
+			size_type _size{};
+
+			uint32_t _block{UINT32_MAX};
+
+			bool isValid() const { return _offset != invalid_offset; }
+		};
+
+		struct stats
+		{
+			size_type _size{};
+
+			size_type _usedSize{};
+
+			// most bytes ever allocated at once
+			size_type _peakUsedSize{};
+
+			// highest allocated end offset ever
+			size_type _highWaterMark{};
+
+			size_type _largestFreeBlock{};
+
+			uint32_t _allocationCount{};
+
+			uint32_t _freeBlockCount{};
+
+			// 0 when free space is single block, close to 1 when free space scattered to small blocks
+			float getFragmentation() const;
+		};
+
+		tlsf_allocator() = default;
+		explicit tlsf_allocator(size_type size);
+
+		void init(size_type size);
+
+		void reset();
+
+		[[nodiscard]] allocation allocate(size_type size, size_type alignment = 1);
+
+		void free(const allocation& alloc);
+
+		// walks all blocks, not intended for per frame use
+		stats getStats() const;
+
+		size_type getSize() const { return _size; }
+
+		size_type getUsedSize() const { return _usedSize; }
+
+	private:
+		static constexpr uint32_t slBits = 5;
+		static constexpr uint32_t slCount = 1U << slBits;
+		static constexpr uint32_t flCount = 64 - slBits + 1;
+		static constexpr uint32_t null_block = UINT32_MAX;
+
+		struct block
+		{
+			size_type _offset{};
+			size_type _size{};
+
+			uint32_t _prevPhys{null_block};
+			uint32_t _nextPhys{null_block};
+
+			uint32_t _prevFree{null_block};
+			uint32_t _nextFree{null_block};
+
+			bool _free{false};
+		};
+
+		static void mapping(size_type size, uint32_t& fl, uint32_t& sl);
+		static void mappingSearch(size_type size, uint32_t& fl, uint32_t& sl);
+
+		uint32_t findFreeBlock(size_type size);
+
+		void insertFreeBlock(uint32_t index);
+		void removeFreeBlock(uint32_t index);
+
+		// splits block at offset from its start, returns index of the second part
+		uint32_t splitBlock(uint32_t index, size_type offset);
+
+		// merges next physical block into this, next block released
+		void mergeWithNext(uint32_t index);
+
+		uint32_t newBlock();
+		void releaseBlock(uint32_t index);
+
+		size_type _size{};
+		size_type _usedSize{};
+		size_type _peakUsedSize{};
+		size_type _highWaterMark{};
+		uint32_t _allocationCount{};
+
+		uint64_t _flBitmap{};
+		std::array<uint32_t, flCount> _slBitmaps{};
+		std::array<std::array<uint32_t, slCount>, flCount> _freeLists{};
+
+		std::vector<block> _blocks{};
+		std::vector<uint32_t> _unusedBlocks{};
+	};
+} // namespace de::allocators
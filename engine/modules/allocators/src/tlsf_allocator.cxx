@@ -0,0 +1,314 @@
+#include "tlsf_allocator.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+float de::allocators::tlsf_allocator::stats::getFragmentation() const
+{
+	const size_type freeSize = _size - _usedSize;
+	if (freeSize == 0)
+	{
+		return 0.F;
+	}
+	return 1.F - static_cast<float>(static_cast<double>(_largestFreeBlock) / static_cast<double>(freeSize));
+}
+
+de::allocators::tlsf_allocator::tlsf_allocator(size_type size)
+{
+	init(size);
+}
+
+void de::allocators::tlsf_allocator::init(size_type size)
+{
+	_size = size;
+	_usedSize = 0;
+	_peakUsedSize = 0;
+	_highWaterMark = 0;
+	_allocationCount = 0;
+
+	_flBitmap = 0;
+	_slBitmaps.fill(0);
+	for (auto& lists : _freeLists)
+	{
+		lists.fill(null_block);
+	}
+
+	_blocks.clear();
+	_unusedBlocks.clear();
+
+	if (_size)
+	{
+		const uint32_t index = newBlock();
+		_blocks[index]._offset = 0;
+		_blocks[index]._size = _size;
+		insertFreeBlock(index);
+	}
+}
+
+void de::allocators::tlsf_allocator::reset()
+{
+	init(_size);
+}
+
+de::allocators::tlsf_allocator::allocation de::allocators::tlsf_allocator::allocate(size_type size, size_type alignment)
+{
+	size = std::max<size_type>(size, 1);
+	alignment = std::max<size_type>(alignment, 1);
+
+	// request enough to always fit aligned offset inside found block
+	const size_type requestSize = size + alignment - 1;
+	if (requestSize < size || requestSize > _size)
+	{
+		return allocation();
+	}
+
+	uint32_t index = findFreeBlock(requestSize);
+	if (index == null_block)
+	{
+		return allocation();
+	}
+	removeFreeBlock(index);
+
+	const size_type offset = _blocks[index]._offset;
+	const size_type remainder = offset % alignment;
+	const size_type padding = remainder ? alignment - remainder : 0;
+	if (padding)
+	{
+		const uint32_t alignedIndex = splitBlock(index, padding);
+		insertFreeBlock(index);
+		index = alignedIndex;
+	}
+
+	if (_blocks[index]._size > size)
+	{
+		const uint32_t tailIndex = splitBlock(index, size);
+		insertFreeBlock(tailIndex);
+	}
+
+	const auto& allocated = _blocks[index];
+
+	_usedSize += allocated._size;
+	_peakUsedSize = std::max(_peakUsedSize, _usedSize);
+	_highWaterMark = std::max(_highWaterMark, allocated._offset + allocated._size);
+	++_allocationCount;
+
+	return allocation{._offset = allocated._offset, ._size = allocated._size, ._block = index};
+}
+
+void de::allocators::tlsf_allocator::free(const allocation& alloc)
+{
+	if (!alloc.isValid())
+	{
+		return;
+	}
+
+	uint32_t index = alloc._block;
+	assert(index < _blocks.size() && !_blocks[index]._free && _blocks[index]._offset == alloc._offset);
+
+	_usedSize -= _blocks[index]._size;
+	--_allocationCount;
+
+	const uint32_t next = _blocks[index]._nextPhys;
+	if (next != null_block && _blocks[next]._free)
+	{
+		removeFreeBlock(next);
+		mergeWithNext(index);
+	}
+
+	const uint32_t prev = _blocks[index]._prevPhys;
+	if (prev != null_block && _blocks[prev]._free)
+	{
+		removeFreeBlock(prev);
+		mergeWithNext(prev);
+		index = prev;
+	}
+
+	insertFreeBlock(index);
+}
+
+de::allocators::tlsf_allocator::stats de::allocators::tlsf_allocator::getStats() const
+{
+	stats out{};
+	out._size = _size;
+	out._usedSize = _usedSize;
+	out._peakUsedSize = _peakUsedSize;
+	out._highWaterMark = _highWaterMark;
+	out._allocationCount = _allocationCount;
+
+	// first block always starts at zero offset and never merged into previous one
+	for (uint32_t i = _blocks.empty() ? null_block : 0; i != null_block; i = _blocks[i]._nextPhys)
+	{
+		const auto& b = _blocks[i];
+		if (b._free)
+		{
+			out._largestFreeBlock = std::max(out._largestFreeBlock, b._size);
+			++out._freeBlockCount;
+		}
+	}
+	return out;
+}
+
+void de::allocators::tlsf_allocator::mapping(size_type size, uint32_t& fl, uint32_t& sl)
+{
+	if (size < slCount)
+	{
+		fl = 0;
+		sl = static_cast<uint32_t>(size);
+	}
+	else
+	{
+		const uint32_t msb = 63 - std::countl_zero(size);
+		sl = static_cast<uint32_t>(size >> (msb - slBits)) ^ slCount;
+		fl = msb - slBits + 1;
+	}
+}
+
+void de::allocators::tlsf_allocator::mappingSearch(size_type size, uint32_t& fl, uint32_t& sl)
+{
+	// round up to next list, so any block found there is large enough
+	if (size >= slCount)
+	{
+		const uint32_t msb = 63 - std::countl_zero(size);
+		const size_type round = (size_type(1) << (msb - slBits)) - 1;
+		size = size + round < size ? size : size + round;
+	}
+	mapping(size, fl, sl);
+}
+
+uint32_t de::allocators::tlsf_allocator::findFreeBlock(size_type size)
+{
+	uint32_t fl, sl;
+	mappingSearch(size, fl, sl);
+	if (fl >= flCount)
+	{
+		return null_block;
+	}
+
+	uint32_t slMap = _slBitmaps[fl] & (~0U << sl);
+	if (slMap == 0)
+	{
+		const uint64_t flMap = fl + 1 < 64 ? _flBitmap & (~uint64_t(0) << (fl + 1)) : 0;
+		if (flMap == 0)
+		{
+			return null_block;
+		}
+		fl = std::countr_zero(flMap);
+		slMap = _slBitmaps[fl];
+	}
+	sl = std::countr_zero(slMap);
+
+	return _freeLists[fl][sl];
+}
+
+void de::allocators::tlsf_allocator::insertFreeBlock(uint32_t index)
+{
+	uint32_t fl, sl;
+	mapping(_blocks[index]._size, fl, sl);
+
+	auto& b = _blocks[index];
+	const uint32_t head = _freeLists[fl][sl];
+
+	b._free = true;
+	b._prevFree = null_block;
+	b._nextFree = head;
+	if (head != null_block)
+	{
+		_blocks[head]._prevFree = index;
+	}
+	_freeLists[fl][sl] = index;
+
+	_flBitmap |= uint64_t(1) << fl;
+	_slBitmaps[fl] |= 1U << sl;
+}
+
+void de::allocators::tlsf_allocator::removeFreeBlock(uint32_t index)
+{
+	uint32_t fl, sl;
+	mapping(_blocks[index]._size, fl, sl);
+
+	auto& b = _blocks[index];
+	if (b._prevFree != null_block)
+	{
+		_blocks[b._prevFree]._nextFree = b._nextFree;
+	}
+	if (b._nextFree != null_block)
+	{
+		_blocks[b._nextFree]._prevFree = b._prevFree;
+	}
+
+	if (_freeLists[fl][sl] == index)
+	{
+		_freeLists[fl][sl] = b._nextFree;
+		if (b._nextFree == null_block)
+		{
+			_slBitmaps[fl] &= ~(1U << sl);
+			if (_slBitmaps[fl] == 0)
+			{
+				_flBitmap &= ~(uint64_t(1) << fl);
+			}
+		}
+	}
+
+	b._free = false;
+	b._prevFree = null_block;
+	b._nextFree = null_block;
+}
+
+uint32_t de::allocators::tlsf_allocator::splitBlock(uint32_t index, size_type offset)
+{
+	// newBlock could reallocate blocks array, take references only after it
+	const uint32_t secondIndex = newBlock();
+
+	auto& first = _blocks[index];
+	auto& second = _blocks[secondIndex];
+
+	second._offset = first._offset + offset;
+	second._size = first._size - offset;
+	second._prevPhys = index;
+	second._nextPhys = first._nextPhys;
+	if (first._nextPhys != null_block)
+	{
+		_blocks[first._nextPhys]._prevPhys = secondIndex;
+	}
+
+	first._size = offset;
+	first._nextPhys = secondIndex;
+
+	return secondIndex;
+}
+
+void de::allocators::tlsf_allocator::mergeWithNext(uint32_t index)
+{
+	auto& b = _blocks[index];
+	const uint32_t nextIndex = b._nextPhys;
+	const auto& next = _blocks[nextIndex];
+
+	b._size += next._size;
+	b._nextPhys = next._nextPhys;
+	if (b._nextPhys != null_block)
+	{
+		_blocks[b._nextPhys]._prevPhys = index;
+	}
+
+	releaseBlock(nextIndex);
+}
+
+uint32_t de::allocators::tlsf_allocator::newBlock()
+{
+	if (!_unusedBlocks.empty())
+	{
+		const uint32_t index = _unusedBlocks.back();
+		_unusedBlocks.pop_back();
+		_blocks[index] = block();
+		return index;
+	}
+	_blocks.emplace_back();
+	return static_cast<uint32_t>(_blocks.size() - 1);
+}
+
+void de::allocators::tlsf_allocator::releaseBlock(uint32_t index)
+{
+	_blocks[index] = block();
+	_unusedBlocks.push_back(index);
+}
@@ -0,0 +1,178 @@
+#include "allocators/tlsf_allocator.hxx"
+#include "test/test.hxx"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using de::allocators::tlsf_allocator;
+
+namespace
+{
+	using de::test::check;
+
+	// live allocations sorted by offset must not overlap and stay inside allocator range
+	bool isNonOverlapping(std::vector<tlsf_allocator::allocation> live, tlsf_allocator::size_type size)
+	{
+		std::sort(live.begin(), live.end(), [](const auto& a, const auto& b)
+			{ return a._offset < b._offset; });
+		for (size_t i = 0; i < live.size(); ++i)
+		{
+			if (live[i]._offset + live[i]._size > size)
+				return false;
+			if (i != 0 && live[i - 1]._offset + live[i - 1]._size > live[i]._offset)
+				return false;
+		}
+		return true;
+	}
+
+	// everything freed must merge back to single block of whole range
+	bool isFullyCoalesced(const tlsf_allocator& allocator)
+	{
+		const auto stats = allocator.getStats();
+		return stats._usedSize == 0 && stats._allocationCount == 0 && stats._freeBlockCount == 1 && stats._largestFreeBlock == allocator.getSize();
+	}
+
+	void testAllocateFree()
+	{
+		tlsf_allocator allocator(1024);
+
+		const auto a = allocator.allocate(100);
+		const auto b = allocator.allocate(200);
+		check(a.isValid() && b.isValid(), "allocations fit");
+		check(isNonOverlapping({a, b}, allocator.getSize()), "allocations do not overlap");
+		check(allocator.getUsedSize() == 300, "used size counts allocations");
+
+		check(!allocator.allocate(2048).isValid(), "allocation larger than range fails");
+
+		allocator.free(a);
+		allocator.free(b);
+		check(isFullyCoalesced(allocator), "freed allocations coalesce");
+
+		check(allocator.allocate(1024).isValid(), "whole range allocatable after free");
+	}
+
+	void testAlignment()
+	{
+		tlsf_allocator allocator(1 << 20);
+
+		// power of two and element size alignments, as vertex ranges use vertex stride
+		const std::array<tlsf_allocator::size_type, 6> alignments{1, 4, 16, 256, 48, 80};
+		std::vector<tlsf_allocator::allocation> live;
+		for (int i = 0; i < 64; ++i)
+		{
+			const auto alignment = alignments[i % alignments.size()];
+			const auto alloc = allocator.allocate(1 + i * 7, alignment);
+			check(alloc.isValid(), "aligned allocation fits");
+			check(alloc._offset % alignment == 0, "offset is multiple of alignment");
+			live.push_back(alloc);
+		}
+		check(isNonOverlapping(live, allocator.getSize()), "aligned allocations do not overlap");
+
+		for (const auto& alloc : live)
+		{
+			allocator.free(alloc);
+		}
+		check(isFullyCoalesced(allocator), "aligned allocations coalesce with their padding");
+	}
+
+	void testCoalescingOrder()
+	{
+		tlsf_allocator allocator(4096);
+
+		std::vector<tlsf_allocator::allocation> live;
+		for (int i = 0; i < 16; ++i)
+		{
+			live.push_back(allocator.allocate(256));
+		}
+		check(!allocator.allocate(1).isValid(), "range exhausted");
+
+		// free every other block, then the rest, so merges happen with both neighbours
+		for (size_t i = 0; i < live.size(); i += 2)
+		{
+			allocator.free(live[i]);
+		}
+		check(allocator.getStats()._freeBlockCount == 8, "separated blocks not merged");
+		for (size_t i = 1; i < live.size(); i += 2)
+		{
+			allocator.free(live[i]);
+		}
+		check(isFullyCoalesced(allocator), "blocks merged with both neighbours");
+	}
+
+	// random allocate and free mix, reports fragmentation and high water mark of the range
+	void testChurn()
+	{
+		constexpr tlsf_allocator::size_type size = 256ULL * 1024 * 1024;
+		constexpr uint32_t operations = 2'000'000;
+		constexpr size_t maxLive = 4096;
+
+		tlsf_allocator allocator(size);
+		std::mt19937 rng(42);
+		std::uniform_int_distribution<tlsf_allocator::size_type> sizeDist(16, 256 * 1024);
+		std::uniform_int_distribution<uint32_t> alignDist(0, 3);
+		constexpr std::array<tlsf_allocator::size_type, 4> alignments{1, 16, 48, 256};
+
+		std::vector<tlsf_allocator::allocation> live;
+		live.reserve(maxLive);
+		uint32_t failed{};
+
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < operations; ++i)
+		{
+			const bool doFree = live.size() == maxLive || (!live.empty() && (rng() & 1));
+			if (doFree)
+			{
+				const size_t index = rng() % live.size();
+				allocator.free(live[index]);
+				live[index] = live.back();
+				live.pop_back();
+			}
+			else
+			{
+				const auto alignment = alignments[alignDist(rng)];
+				const auto alloc = allocator.allocate(sizeDist(rng), alignment);
+				if (!alloc.isValid())
+				{
+					++failed;
+					continue;
+				}
+				if (alloc._offset % alignment != 0)
+				{
+					check(false, "churn offset is multiple of alignment");
+				}
+				live.push_back(alloc);
+			}
+		}
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		check(isNonOverlapping(live, size), "churn allocations do not overlap");
+
+		const auto stats = allocator.getStats();
+		std::printf("churn: %u operations in %.1f ms (%.1f ns/op), %u failed\n", operations, elapsed, elapsed * 1e6 / operations, failed);
+		std::printf("churn: live %u, used %llu, peak used %llu, high water mark %llu of %llu\n",
+			stats._allocationCount, static_cast<unsigned long long>(stats._usedSize), static_cast<unsigned long long>(stats._peakUsedSize),
+			static_cast<unsigned long long>(stats._highWaterMark), static_cast<unsigned long long>(stats._size));
+		std::printf("churn: free blocks %u, largest free %llu, fragmentation %.3f\n",
+			stats._freeBlockCount, static_cast<unsigned long long>(stats._largestFreeBlock), stats.getFragmentation());
+
+		for (const auto& alloc : live)
+		{
+			allocator.free(alloc);
+		}
+		check(isFullyCoalesced(allocator), "churn allocations coalesce");
+	}
+} // namespace
+
+int main()
+{
+	testAllocateFree();
+	testAlignment();
+	testCoalescingOrder();
+	testChurn();
+
+	return de::test::result();
+}
\ No newline at end of file
@@ -7,7 +7,8 @@
 
 namespace de::gltf
 {
-	DRECO_API de::gltf::model loadModel(const std::string_view sceneFile);
+	// when loadImages is false, only image uri's are filled and pixels left empty
+	DRECO_API de::gltf::model loadModel(const std::string_view sceneFile, bool loadImages = true);
 
 	DRECO_API de::gltf::image loadImage(const std::string_view imageFile);
 } // namespace de::gltf
\ No newline at end of file
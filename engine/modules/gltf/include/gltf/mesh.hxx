@@ -1,4 +1,5 @@
 #pragma once
+#include "math/aabb.hxx"
 #include "math/vec2.hxx"
 #include "math/vec3.hxx"
 #include "math/vec4.hxx"
@@ -27,6 +28,9 @@ namespace de::gltf
 			std::vector<vertex> _vertexes;
 			std::vector<uint32_t> _indexes;
 
+			// bounds in mesh space, kept even after vertexes released
+			math::aabb _bounds;
+
 			uint32_t _material{UINT32_MAX};
 		};
 		std::string _name;
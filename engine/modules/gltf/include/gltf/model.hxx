@@ -24,5 +24,45 @@ namespace de::gltf
 		std::vector<de::gltf::scene> _scenes;
 
 		std::vector<de::gltf::node> _nodes;
+
+		// approximate size of vertex, index and pixel data held by model, in bytes
+		size_t getMemoryUsage() const
+		{
+			size_t size{};
+			for (const auto& mesh : _meshes)
+			{
+				for (const auto& primitive : mesh._primitives)
+				{
+					size += primitive._vertexes.capacity() * sizeof(de::gltf::mesh::primitive::vertex);
+					size += primitive._indexes.capacity() * sizeof(uint32_t);
+				}
+			}
+			for (const auto& image : _images)
+			{
+				size += image._pixels.capacity();
+			}
+			return size;
+		}
+
+		// free vertex and index data, primitive bounds and materials stay
+		void releaseMeshesData()
+		{
+			for (auto& mesh : _meshes)
+			{
+				for (auto& primitive : mesh._primitives)
+				{
+					std::vector<de::gltf::mesh::primitive::vertex>().swap(primitive._vertexes);
+					std::vector<uint32_t>().swap(primitive._indexes);
+				}
+			}
+		}
+
+		void releaseImagesData()
+		{
+			for (auto& image : _images)
+			{
+				std::vector<uint8_t>().swap(image._pixels);
+			}
+		}
 	};
 } // namespace de::gltf
\ No newline at end of file
@@ -19,5 +19,8 @@ namespace de::gltf
 
 		math::transform _transform;
 		math::mat4 _matrix;
+
+		// local instance transforms from EXT_mesh_gpu_instancing, empty if not instanced
+		std::vector<math::mat4> _instances;
 	};
 } // namespace de::gltf
\ No newline at end of file
@@ -8,7 +8,9 @@
 #include <cstring>
 #include <execution>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -18,8 +20,15 @@
 #define TINYGLTF_NO_STB_IMAGE
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 #define TINYGLTF_NO_EXTERNAL_IMAGE
+#ifdef DRECO_HAS_DRACO
+#define TINYGLTF_ENABLE_DRACO
+#endif
 #include "tinygltf/tiny_gltf.h"
 
+#ifdef DRECO_HAS_MESHOPTIMIZER
+#include <meshoptimizer.h>
+#endif
+
 // t - for tiny, d - for dreco
 
 static de::math::mat4 parseMatrix(const std::vector<double>& matrix)
@@ -40,6 +49,240 @@ static de::math::mat4 parseMatrix(const std::vector<double>& matrix)
 	return out;
 }
 
+// reads accessor elements as floats, respecting byte stride, integer component types and normalization
+// quantized attributes are common for compressed assets (KHR_mesh_quantization)
+struct accessor_view
+{
+	accessor_view(const tinygltf::Model& tModel, const tinygltf::Accessor& accessor)
+		: _componentType{accessor.componentType}
+		, _components{static_cast<size_t>(tinygltf::GetNumComponentsInType(accessor.type))}
+		, _normalized{accessor.normalized}
+		, _count{accessor.count}
+	{
+		if (accessor.bufferView < 0)
+			return;
+
+		const auto& bufferView{tModel.bufferViews[accessor.bufferView]};
+		const auto& buffer{tModel.buffers[bufferView.buffer]};
+		_data = &buffer.data[bufferView.byteOffset + accessor.byteOffset];
+		_stride = static_cast<size_t>(accessor.ByteStride(bufferView));
+	}
+
+	template <size_t N>
+	std::array<float, N> get(size_t index) const
+	{
+		std::array<float, N> out{};
+		if (_data == nullptr)
+			return out;
+
+		const uint8_t* element = _data + index * _stride;
+		for (size_t i = 0; i < std::min(N, _components); ++i)
+		{
+			out[i] = getComponent(element, i);
+		}
+		return out;
+	}
+
+	uint32_t getIndex(size_t index) const
+	{
+		if (_data == nullptr)
+			return 0;
+
+		const uint8_t* element = _data + index * _stride;
+		switch (_componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return *element;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return *reinterpret_cast<const uint16_t*>(element);
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: return *reinterpret_cast<const uint32_t*>(element);
+		default: return 0;
+		}
+	}
+
+	size_t getCount() const { return _count; }
+
+private:
+	float getComponent(const uint8_t* element, size_t component) const
+	{
+		switch (_componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_FLOAT:
+			return reinterpret_cast<const float*>(element)[component];
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+		{
+			const float value = reinterpret_cast<const int8_t*>(element)[component];
+			return _normalized ? std::max(value / 127.F, -1.F) : value;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		{
+			const float value = element[component];
+			return _normalized ? value / 255.F : value;
+		}
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+		{
+			const float value = reinterpret_cast<const int16_t*>(element)[component];
+			return _normalized ? std::max(value / 32767.F, -1.F) : value;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			const float value = reinterpret_cast<const uint16_t*>(element)[component];
+			return _normalized ? value / 65535.F : value;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+			return static_cast<float>(reinterpret_cast<const uint32_t*>(element)[component]);
+		default:
+			return 0.F;
+		}
+	}
+
+	const uint8_t* _data{};
+	size_t _stride{};
+	int _componentType{};
+	size_t _components{};
+	bool _normalized{};
+	size_t _count{};
+};
+
+// tinygltf rejects buffers without uri in .gltf files, yet EXT_meshopt_compression fallback buffers come without one.
+// point them to a tiny data uri, storage for them is restored when compressed buffer views get decoded
+static std::string patchMeshoptFallbackBuffers(const std::string& gltfJson)
+{
+	auto json = nlohmann::json::parse(gltfJson, nullptr, false);
+	if (json.is_discarded() || json.count("buffers") == 0)
+	{
+		return gltfJson;
+	}
+
+	for (auto& buffer : json["buffers"])
+	{
+		const bool isFallback = buffer.count("extensions") && buffer["extensions"].count("EXT_meshopt_compression");
+		if (isFallback && buffer.count("uri") == 0)
+		{
+			buffer["uri"] = "data:application/octet-stream;base64,AAAA";
+			buffer["byteLength"] = 3;
+		}
+	}
+	return json.dump();
+}
+
+// decodes EXT_meshopt_compression buffer views into their fallback buffers, so accessors could read them as usual
+static void decodeMeshoptBufferViews(tinygltf::Model& tModel)
+{
+	std::vector<tinygltf::BufferView*> compressedViews;
+	for (auto& tBufferView : tModel.bufferViews)
+	{
+		const auto extIt = tBufferView.extensions.find("EXT_meshopt_compression");
+		if (extIt == tBufferView.extensions.end())
+			continue;
+
+		// ranges come from file, decoding reads and writes them unchecked
+		const auto& ext = extIt->second;
+		const int srcBufferIndex = ext.Has("buffer") ? ext.Get("buffer").GetNumberAsInt() : -1;
+		const int srcOffset = ext.Has("byteOffset") ? ext.Get("byteOffset").GetNumberAsInt() : 0;
+		const int srcLength = ext.Has("byteLength") ? ext.Get("byteLength").GetNumberAsInt() : -1;
+		const int stride = ext.Has("byteStride") ? ext.Get("byteStride").GetNumberAsInt() : 0;
+		const int count = ext.Has("count") ? ext.Get("count").GetNumberAsInt() : -1;
+
+		if (tBufferView.buffer < 0 || static_cast<size_t>(tBufferView.buffer) >= tModel.buffers.size() ||
+			srcBufferIndex < 0 || static_cast<size_t>(srcBufferIndex) >= tModel.buffers.size())
+		{
+			DE_LOG(Error, "%s: compressed buffer view refers to missing buffer, skipped", __FUNCTION__);
+			continue;
+		}
+		if (srcOffset < 0 || srcLength < 0 || stride <= 0 || count < 0 ||
+			static_cast<size_t>(srcOffset) + static_cast<size_t>(srcLength) > tModel.buffers[srcBufferIndex].data.size())
+		{
+			DE_LOG(Error, "%s: compressed data out of buffer range, skipped", __FUNCTION__);
+			continue;
+		}
+		if (static_cast<size_t>(count) * static_cast<size_t>(stride) > tBufferView.byteLength)
+		{
+			DE_LOG(Error, "%s: decoded data larger than buffer view, skipped", __FUNCTION__);
+			continue;
+		}
+
+		// strides meshoptimizer decoders and filters accept, others would hit its asserts
+		const std::string mode = ext.Has("mode") && ext.Get("mode").IsString() ? ext.Get("mode").Get<std::string>() : "";
+		const std::string filter = ext.Has("filter") && ext.Get("filter").IsString() ? ext.Get("filter").Get<std::string>() : "NONE";
+		bool validMode = false;
+		if (mode == "ATTRIBUTES")
+			validMode = stride % 4 == 0 && stride <= 256;
+		else if (mode == "TRIANGLES")
+			validMode = (stride == 2 || stride == 4) && count % 3 == 0;
+		else if (mode == "INDICES")
+			validMode = stride == 2 || stride == 4;
+
+		bool validFilter = false;
+		if (filter == "NONE")
+			validFilter = true;
+		else if (filter == "OCTAHEDRAL")
+			validFilter = stride == 4 || stride == 8;
+		else if (filter == "QUATERNION")
+			validFilter = stride == 8;
+		else if (filter == "EXPONENTIAL")
+			validFilter = stride % 4 == 0;
+
+		if (!validMode || !validFilter)
+		{
+			DE_LOG(Error, "%s: invalid mode %s or filter %s for stride %i, skipped", __FUNCTION__, mode.c_str(), filter.c_str(), stride);
+			continue;
+		}
+
+		// views of the same buffer are decoded in parallel, make sure storage is there beforehand
+		auto& data = tModel.buffers[tBufferView.buffer].data;
+		data.resize(std::max(data.size(), tBufferView.byteOffset + tBufferView.byteLength));
+
+		compressedViews.push_back(&tBufferView);
+	}
+
+	if (compressedViews.empty())
+	{
+		return;
+	}
+
+#ifdef DRECO_HAS_MESHOPTIMIZER
+	const auto decodeView = [&tModel](tinygltf::BufferView* tBufferView)
+	{
+		const auto& ext = tBufferView->extensions.at("EXT_meshopt_compression");
+
+		// ranges validated when view collected
+		const auto& srcBuffer = tModel.buffers[ext.Get("buffer").GetNumberAsInt()];
+		const size_t srcOffset = ext.Has("byteOffset") ? ext.Get("byteOffset").GetNumberAsInt() : 0;
+		const size_t srcLength = ext.Get("byteLength").GetNumberAsInt();
+		const size_t stride = ext.Get("byteStride").GetNumberAsInt();
+		const size_t count = ext.Get("count").GetNumberAsInt();
+		const std::string mode = ext.Get("mode").Get<std::string>();
+		const std::string filter = ext.Has("filter") ? ext.Get("filter").Get<std::string>() : "NONE";
+
+		uint8_t* dst = tModel.buffers[tBufferView->buffer].data.data() + tBufferView->byteOffset;
+		const uint8_t* src = srcBuffer.data.data() + srcOffset;
+
+		int result = -1;
+		if (mode == "ATTRIBUTES")
+			result = meshopt_decodeVertexBuffer(dst, count, stride, src, srcLength);
+		else if (mode == "TRIANGLES")
+			result = meshopt_decodeIndexBuffer(dst, count, stride, src, srcLength);
+		else if (mode == "INDICES")
+			result = meshopt_decodeIndexSequence(dst, count, stride, src, srcLength);
+
+		if (result != 0)
+		{
+			DE_LOG(Error, "%s: failed to decode buffer view, mode: %s, result: %i", __FUNCTION__, mode.c_str(), result);
+			return;
+		}
+
+		if (filter == "OCTAHEDRAL")
+			meshopt_decodeFilterOct(dst, count, stride);
+		else if (filter == "QUATERNION")
+			meshopt_decodeFilterQuat(dst, count, stride);
+		else if (filter == "EXPONENTIAL")
+			meshopt_decodeFilterExp(dst, count, stride);
+	};
+	std::for_each(std::execution::par, compressedViews.begin(), compressedViews.end(), decodeView);
+#else
+	DE_LOG(Error, "%s: model uses EXT_meshopt_compression, but dreco-gltf was built without meshoptimizer", __FUNCTION__);
+#endif
+}
+
 static void parseScenes(const tinygltf::Model& tModel, de::gltf::model& dModel)
 {
 	dModel._sceneIndex = static_cast<uint32_t>(tModel.defaultScene);
@@ -62,6 +305,56 @@ static void parseScenes(const tinygltf::Model& tModel, de::gltf::model& dModel)
 	}
 }
 
+static void parseMeshGpuInstancing(const tinygltf::Model& tModel, const tinygltf::Value& extension, de::gltf::node& dNode)
+{
+	if (!extension.Has("attributes"))
+		return;
+
+	const auto& attributes = extension.Get("attributes");
+	const auto getAccessor = [&tModel, &attributes](const std::string& name) -> const tinygltf::Accessor*
+	{
+		if (!attributes.Has(name))
+			return nullptr;
+		const int index = attributes.Get(name).GetNumberAsInt();
+		return index >= 0 && index < static_cast<int>(tModel.accessors.size()) ? &tModel.accessors[index] : nullptr;
+	};
+
+	const auto translationAccessor = getAccessor("TRANSLATION");
+	const auto rotationAccessor = getAccessor("ROTATION");
+	const auto scaleAccessor = getAccessor("SCALE");
+
+	size_t count = 0;
+	for (const auto accessor : {translationAccessor, rotationAccessor, scaleAccessor})
+	{
+		if (accessor)
+			count = std::max(count, accessor->count);
+	}
+
+	dNode._instances.resize(count, de::math::mat4::makeIdentity());
+	for (size_t i = 0; i < count; ++i)
+	{
+		de::math::vec3 translation{};
+		de::math::quaternion rotation = de::math::quaternion::identity();
+		de::math::vec3 scale{1.F, 1.F, 1.F};
+		if (translationAccessor && i < translationAccessor->count)
+		{
+			const auto t = accessor_view(tModel, *translationAccessor).get<3>(i);
+			translation = de::math::vec3(t[0], t[1], t[2]);
+		}
+		if (rotationAccessor && i < rotationAccessor->count)
+		{
+			const auto r = accessor_view(tModel, *rotationAccessor).get<4>(i);
+			rotation = de::math::quaternion(r[0], r[1], r[2], r[3]);
+		}
+		if (scaleAccessor && i < scaleAccessor->count)
+		{
+			const auto s = accessor_view(tModel, *scaleAccessor).get<3>(i);
+			scale = de::math::vec3(s[0], s[1], s[2]);
+		}
+		dNode._instances[i] = de::math::mat4::makeTranslation(translation) * de::math::mat4::makeRotation(rotation) * de::math::mat4::makeScale(scale);
+	}
+}
+
 static void parseNodes(const tinygltf::Model& tModel, de::gltf::model& dModel)
 {
 	const size_t totalNodes = tModel.nodes.size();
@@ -107,6 +400,12 @@ static void parseNodes(const tinygltf::Model& tModel, de::gltf::model& dModel)
 			dNode._matrix = parseMatrix(tNode.matrix);
 			dNode._transform = de::math::transform_cast<de::math::transform>(dNode._matrix);
 		}
+
+		const auto instancing = tNode.extensions.find("EXT_mesh_gpu_instancing");
+		if (instancing != tNode.extensions.end())
+		{
+			parseMeshGpuInstancing(tModel, instancing->second, dNode);
+		}
 	}
 }
 
@@ -156,71 +455,55 @@ static void parseMeshes(const tinygltf::Model& tModel, de::gltf::model& dModel)
 				}
 			}
 
-			dPrimitive._vertexes.resize(tModel.accessors[vertPosAccessor].count);
+			if (vertPosAccessor == UINT32_MAX)
+				continue;
+
+			const accessor_view positions(tModel, tModel.accessors[vertPosAccessor]);
+			dPrimitive._vertexes.resize(positions.getCount());
+			for (size_t q = 0; q < positions.getCount(); ++q)
+			{
+				const auto pos = positions.get<3>(q);
+				dPrimitive._vertexes[q]._pos = de::math::vec3(pos[0], pos[1], pos[2]);
+				dPrimitive._bounds.extend(dPrimitive._vertexes[q]._pos);
+			}
 
 			if (indexAccessor != UINT32_MAX)
-				dPrimitive._indexes.resize(tModel.accessors[indexAccessor].count);
+			{
+				const accessor_view indexes(tModel, tModel.accessors[indexAccessor]);
+				dPrimitive._indexes.resize(indexes.getCount());
+				for (size_t q = 0; q < indexes.getCount(); ++q)
+				{
+					dPrimitive._indexes[q] = indexes.getIndex(q);
+				}
+			}
+
+			if (normalAccessor != UINT32_MAX)
+			{
+				const accessor_view normals(tModel, tModel.accessors[normalAccessor]);
+				for (size_t q = 0; q < std::min(normals.getCount(), dPrimitive._vertexes.size()); ++q)
+				{
+					const auto normal = normals.get<3>(q);
+					dPrimitive._vertexes[q]._normal = de::math::vec3(normal[0], normal[1], normal[2]);
+				}
+			}
 
-			const std::array<uint32_t, 5> usedAccessors{vertPosAccessor, indexAccessor, texCoordAccessor, normalAccessor, colorAccessor};
-			for (const uint32_t accessorIndex : usedAccessors)
+			if (texCoordAccessor != UINT32_MAX)
 			{
-				if (accessorIndex == UINT32_MAX)
-					continue;
-				const auto& accessor{tModel.accessors[accessorIndex]};
-				const auto& bufferView{tModel.bufferViews[accessor.bufferView]};
-				const auto& buffer{tModel.buffers[bufferView.buffer]};
-				const float* positions = reinterpret_cast<const float*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
-
-				for (size_t q = 0; q < accessor.count; ++q)
+				const accessor_view texCoords(tModel, tModel.accessors[texCoordAccessor]);
+				for (size_t q = 0; q < std::min(texCoords.getCount(), dPrimitive._vertexes.size()); ++q)
 				{
-					if (accessorIndex == vertPosAccessor && accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
-					{
-						de::math::vec3& pos{dPrimitive._vertexes[q]._pos};
-						pos._x = positions[q * 3 + 0];
-						pos._y = positions[q * 3 + 1];
-						pos._z = positions[q * 3 + 2];
-					}
-					else if (accessorIndex == indexAccessor)
-					{
-						if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-						{
-							const uint16_t* indexPos = reinterpret_cast<const uint16_t*>(positions);
-							dPrimitive._indexes[q] = indexPos[q];
-						}
-						else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
-						{
-							const uint32_t* indexPos = reinterpret_cast<const uint32_t*>(positions);
-							dPrimitive._indexes[q] = indexPos[q];
-						}
-					}
-					else if (accessorIndex == texCoordAccessor)
-					{
-						de::math::vec2& texCoor{dPrimitive._vertexes[q]._texCoord};
-						texCoor._u = positions[q * 2 + 0];
-						texCoor._v = positions[q * 2 + 1];
-					}
-					else if (accessorIndex == normalAccessor)
-					{
-						de::math::vec3& normal{dPrimitive._vertexes[q]._normal};
-						normal._x = positions[q * 3 + 0];
-						normal._y = positions[q * 3 + 1];
-						normal._z = positions[q * 3 + 2];
-					}
-					else if (accessorIndex == colorAccessor)
-					{
-						de::math::vec4& color{dPrimitive._vertexes[q]._color};
-						const uint8_t size = accessor.type == TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3 ? 3 : 4;
-						if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
-						{
-							color._r = positions[q * size + 0];
-							color._g = positions[q * size + 1];
-							color._b = positions[q * size + 2];
-							if (size == 4)
-							{
-								color._a = positions[q * size + 3];
-							}
-						}
-					}
+					const auto texCoord = texCoords.get<2>(q);
+					dPrimitive._vertexes[q]._texCoord = de::math::vec2(texCoord[0], texCoord[1]);
+				}
+			}
+
+			if (colorAccessor != UINT32_MAX)
+			{
+				const accessor_view colors(tModel, tModel.accessors[colorAccessor]);
+				for (size_t q = 0; q < std::min(colors.getCount(), dPrimitive._vertexes.size()); ++q)
+				{
+					const auto color = colors.get<4>(q);
+					dPrimitive._vertexes[q]._color = de::math::vec4(color[0], color[1], color[2], color[3]);
 				}
 			}
 		}
@@ -254,7 +537,7 @@ static void parseMaterials(const tinygltf::Model& tModel, de::gltf::model& dMode
 	}
 }
 
-static void parseImages(const tinygltf::Model& tModel, de::gltf::model& dModel)
+static void parseImages(const tinygltf::Model& tModel, de::gltf::model& dModel, bool loadImages)
 {
 	const size_t totalImages = tModel.images.size();
 
@@ -264,6 +547,11 @@ static void parseImages(const tinygltf::Model& tModel, de::gltf::model& dModel)
 		dModel._images[i]._uri = tModel.images[i].uri;
 	}
 
+	if (!loadImages)
+	{
+		return;
+	}
+
 	const auto asyncImageLoad = [&dModel](de::gltf::image& image)
 	{
 		image = std::move(de::gltf::loadImage(dModel._rootPath + '/' + image._uri));
@@ -271,14 +559,25 @@ static void parseImages(const tinygltf::Model& tModel, de::gltf::model& dModel)
 	std::for_each(std::execution::par, dModel._images.begin(), dModel._images.end(), asyncImageLoad);
 }
 
-de::gltf::model de::gltf::loadModel(const std::string_view sceneFile)
+de::gltf::model de::gltf::loadModel(const std::string_view sceneFile, bool loadImages)
 {
+	std::ifstream file(sceneFile.data(), std::ios::binary);
+	std::stringstream fileStream;
+	fileStream << file.rdbuf();
+
+	std::string gltfJson = fileStream.str();
+	if (gltfJson.find("EXT_meshopt_compression") != std::string::npos)
+	{
+		gltfJson = patchMeshoptFallbackBuffers(gltfJson);
+	}
+
 	tinygltf::Model tModel;
 	tinygltf::TinyGLTF loader;
 	std::string err;
 	std::string warn;
 
-	const bool result = loader.LoadASCIIFromFile(&tModel, &err, &warn, sceneFile.data());
+	const std::string baseDir = std::filesystem::path(sceneFile).parent_path().generic_string();
+	const bool result = !gltfJson.empty() && loader.LoadASCIIFromString(&tModel, &err, &warn, gltfJson.data(), gltfJson.size(), baseDir);
 	if (!result)
 	{
 		DE_LOG(Error, "Failed to load scene: %s; Current work dir: %s", sceneFile.data(), std::filesystem::current_path().generic_string().data());
@@ -289,14 +588,16 @@ de::gltf::model de::gltf::loadModel(const std::string_view sceneFile)
 		DE_LOG(Warn, "Load scene warning: %s", warn.data());
 	}
 
+	decodeMeshoptBufferViews(tModel);
+
 	gltf::model dModel;
-	dModel._rootPath = std::filesystem::path(sceneFile).parent_path().generic_string();
+	dModel._rootPath = baseDir;
 
 	parseScenes(tModel, dModel);
 	parseNodes(tModel, dModel);
 	parseMaterials(tModel, dModel);
 	parseMeshes(tModel, dModel);
-	parseImages(tModel, dModel);
+	parseImages(tModel, dModel, loadImages);
 
 	return dModel;
 }
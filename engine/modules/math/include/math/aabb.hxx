@@ -0,0 +1,82 @@
+#pragma once
+#include "mat4.hxx"
+#include "vec3.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace de::math
+{
+	// axis aligned bounding box, default constructed box is empty (invalid)
+	struct aabb
+	{
+		aabb() = default;
+		explicit aabb(const vec3& min, const vec3& max)
+			: _min{min}
+			, _max{max}
+		{
+		}
+
+		vec3 _min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+
+		vec3 _max{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+
+		bool isValid() const
+		{
+			return _min._x <= _max._x && _min._y <= _max._y && _min._z <= _max._z;
+		}
+
+		vec3 getCenter() const
+		{
+			return (_min + _max) * 0.5F;
+		}
+
+		vec3 getExtent() const
+		{
+			return (_max - _min) * 0.5F;
+		}
+
+		aabb& extend(const vec3& point)
+		{
+			_min = vec3(std::min(_min._x, point._x), std::min(_min._y, point._y), std::min(_min._z, point._z));
+			_max = vec3(std::max(_max._x, point._x), std::max(_max._y, point._y), std::max(_max._z, point._z));
+			return *this;
+		}
+
+		aabb& extend(const aabb& other)
+		{
+			if (other.isValid())
+			{
+				extend(other._min);
+				extend(other._max);
+			}
+			return *this;
+		}
+
+		// bounds of this box after transformation, computed from center and extent
+		aabb transform(const mat4& mat) const
+		{
+			if (!isValid())
+			{
+				return aabb();
+			}
+
+			const vec3 center = getCenter();
+			const vec3 extent = getExtent();
+			const std::array<float, 3> centerArr = {center._x, center._y, center._z};
+			const std::array<float, 3> extentArr = {extent._x, extent._y, extent._z};
+
+			vec3 newCenter = mat.getTranslation();
+			vec3 newExtent{};
+			for (uint8_t i = 0; i < 3; ++i)
+			{
+				const vec3 col = vec3(*mat[i]);
+				newCenter += col * centerArr[i];
+				newExtent += vec3(std::abs(col._x), std::abs(col._y), std::abs(col._z)) * extentArr[i];
+			}
+			return aabb(newCenter - newExtent, newCenter + newExtent);
+		}
+	};
+} // namespace de::math
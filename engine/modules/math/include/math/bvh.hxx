@@ -0,0 +1,98 @@
+#pragma once
+#include "aabb.hxx"
+#include "frustum.hxx"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace de::math
+{
+	// bounding volume hierarchy over boxes of items, built once and walked every frame.
+	// items of every node laid out next to each other, so subtree entirely inside of frustum visited without tests
+	class bvh
+	{
+	public:
+		struct node
+		{
+			aabb _bounds;
+
+			uint32_t _firstItem{};
+			uint32_t _itemCount{};
+
+			// children at _firstChild and _firstChild + 1, zero for leaf since root never a child
+			uint32_t _firstChild{};
+		};
+
+		// items are indexes to itemBounds
+		void build(const std::vector<aabb>& itemBounds, uint32_t maxLeafItems = 4);
+
+		void clear();
+
+		bool isEmpty() const { return _nodes.empty(); }
+
+		// calls visible with every item which bounds not entirely outside of frustum
+		template <typename Func>
+		void query(const frustum& frustum, Func&& visible) const;
+
+		const std::vector<node>& getNodes() const { return _nodes; }
+
+		const std::vector<uint32_t>& getItems() const { return _items; }
+
+	private:
+		void buildNode(const std::vector<aabb>& itemBounds, uint32_t nodeIndex, uint32_t maxLeafItems);
+
+		std::vector<node> _nodes;
+		std::vector<uint32_t> _items;
+
+		// bounds of _items in the same order, tested one by one in leaves
+		std::vector<aabb> _itemBounds;
+	};
+
+	template <typename Func>
+	void bvh::query(const frustum& frustum, Func&& visible) const
+	{
+		if (_nodes.empty())
+		{
+			return;
+		}
+
+		// median splits keep depth within log2 of item count
+		std::array<uint32_t, 64> stack;
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize != 0)
+		{
+			const node& current = _nodes[stack[--stackSize]];
+			const auto result = frustum.classify(current._bounds);
+			if (result == frustum::intersection::outside)
+			{
+				continue;
+			}
+
+			if (result == frustum::intersection::inside)
+			{
+				for (uint32_t i = current._firstItem; i < current._firstItem + current._itemCount; ++i)
+				{
+					visible(_items[i]);
+				}
+				continue;
+			}
+
+			if (current._firstChild == 0)
+			{
+				for (uint32_t i = current._firstItem; i < current._firstItem + current._itemCount; ++i)
+				{
+					if (frustum.isVisible(_itemBounds[i]))
+					{
+						visible(_items[i]);
+					}
+				}
+				continue;
+			}
+
+			stack[stackSize++] = current._firstChild + 1;
+			stack[stackSize++] = current._firstChild;
+		}
+	}
+} // namespace de::math
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "aabb.hxx"
+#include "mat4.hxx"
+#include "vec3.hxx"
+#include "vec4.hxx"
+
+#include <array>
+#include <cstdint>
+
+namespace de::math
+{
+	// planes of clip volume with vulkan depth range, point inside if dot(plane.xyz, point) + plane.w >= 0 for every plane
+	struct frustum
+	{
+		enum class intersection : uint8_t
+		{
+			outside,
+			intersects,
+			inside
+		};
+
+		std::array<vec4, 6> _planes{};
+
+		// planes component by component for simd tests, padded to 8 with planes every point is inside of
+		alignas(32) std::array<float, 8> _planesX{};
+		alignas(32) std::array<float, 8> _planesY{};
+		alignas(32) std::array<float, 8> _planesZ{};
+		alignas(32) std::array<float, 8> _planesW{1.F, 1.F, 1.F, 1.F, 1.F, 1.F, 1.F, 1.F};
+
+		// viewProj transforms to clip space with proj applied after view, that is view * proj with mat4 operator*.
+		// planes in space the view matrix transforms from
+		static frustum makeFromViewProjection(const mat4& viewProj);
+
+		// inside if box entirely inside of every plane, outside if entirely outside of some plane
+		intersection classify(const aabb& box) const;
+
+		// plane by plane classify without simd, result same as classify
+		intersection classifyScalar(const aabb& box) const;
+
+		bool isVisible(const aabb& box) const
+		{
+			return classify(box) != intersection::outside;
+		}
+	};
+} // namespace de::math
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "bvh.hxx"
+
+#include <algorithm>
+#include <numeric>
+
+void de::math::bvh::build(const std::vector<aabb>& itemBounds, uint32_t maxLeafItems)
+{
+	clear();
+	if (itemBounds.empty())
+	{
+		return;
+	}
+
+	_items.resize(itemBounds.size());
+	std::iota(_items.begin(), _items.end(), 0);
+
+	_nodes.reserve(itemBounds.size() * 2);
+	_nodes.push_back(node{._bounds = aabb(), ._firstItem = 0, ._itemCount = static_cast<uint32_t>(_items.size()), ._firstChild = 0});
+	buildNode(itemBounds, 0, std::max(maxLeafItems, 1U));
+
+	_itemBounds.reserve(_items.size());
+	for (const auto item : _items)
+	{
+		_itemBounds.push_back(itemBounds[item]);
+	}
+}
+
+void de::math::bvh::clear()
+{
+	_nodes.clear();
+	_items.clear();
+	_itemBounds.clear();
+}
+
+void de::math::bvh::buildNode(const std::vector<aabb>& itemBounds, uint32_t nodeIndex, uint32_t maxLeafItems)
+{
+	const auto first = _items.begin() + _nodes[nodeIndex]._firstItem;
+	const auto last = first + _nodes[nodeIndex]._itemCount;
+
+	aabb bounds, centers;
+	for (auto it = first; it != last; ++it)
+	{
+		bounds.extend(itemBounds[*it]);
+		if (itemBounds[*it].isValid())
+		{
+			centers.extend(itemBounds[*it].getCenter());
+		}
+	}
+	_nodes[nodeIndex]._bounds = bounds;
+
+	if (_nodes[nodeIndex]._itemCount <= maxLeafItems || !centers.isValid())
+	{
+		return;
+	}
+
+	// split at median of item centers along longest axis of them
+	const vec3 size = centers._max - centers._min;
+	uint8_t axis = 0;
+	if (size._y > size._x && size._y >= size._z)
+	{
+		axis = 1;
+	}
+	else if (size._z > size._x && size._z > size._y)
+	{
+		axis = 2;
+	}
+
+	const auto center = [&itemBounds, axis](uint32_t item)
+	{
+		const vec3 value = itemBounds[item].getCenter();
+		return axis == 0 ? value._x : axis == 1 ? value._y : value._z;
+	};
+
+	const auto middle = first + std::distance(first, last) / 2;
+	std::nth_element(first, middle, last, [&center](uint32_t a, uint32_t b)
+		{ return center(a) < center(b); });
+
+	const uint32_t firstChild = _nodes.size();
+	const uint32_t leftCount = std::distance(first, middle);
+	_nodes.push_back(node{._bounds = aabb(), ._firstItem = _nodes[nodeIndex]._firstItem, ._itemCount = leftCount, ._firstChild = 0});
+	_nodes.push_back(node{._bounds = aabb(), ._firstItem = _nodes[nodeIndex]._firstItem + leftCount, ._itemCount = _nodes[nodeIndex]._itemCount - leftCount, ._firstChild = 0});
+	_nodes[nodeIndex]._firstChild = firstChild;
+
+	buildNode(itemBounds, firstChild, maxLeafItems);
+	buildNode(itemBounds, firstChild + 1, maxLeafItems);
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "frustum.hxx"
+
+#include <cmath>
+
+// sse is part of every x86-64 target, so enabled without extra compile flags
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DRECO_MATH_SSE
+#endif
+
+de::math::frustum de::math::frustum::makeFromViewProjection(const mat4& viewProj)
+{
+	const auto row = [&viewProj](uint8_t index)
+	{
+		return vec4(viewProj[0][index], viewProj[1][index], viewProj[2][index], viewProj[3][index]);
+	};
+	vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+
+	frustum out;
+	out._planes[0] = w + x; // left
+	out._planes[1] = w - x; // right
+	out._planes[2] = w + y; // top
+	out._planes[3] = w - y; // bottom
+	out._planes[4] = z;		// near
+	out._planes[5] = w - z; // far
+
+	for (size_t i = 0; i < out._planes.size(); ++i)
+	{
+		out._planesX[i] = out._planes[i]._x;
+		out._planesY[i] = out._planes[i]._y;
+		out._planesZ[i] = out._planes[i]._z;
+		out._planesW[i] = out._planes[i]._w;
+	}
+	return out;
+}
+
+de::math::frustum::intersection de::math::frustum::classify(const aabb& box) const
+{
+	if (!box.isValid())
+	{
+		return intersection::outside;
+	}
+
+	const vec3 center = box.getCenter();
+	const vec3 extent = box.getExtent();
+
+	// distance of box center to plane against projection of box extent on plane normal
+#if defined(DRECO_MATH_SSE)
+	const __m128 signMask = _mm_set1_ps(-0.F);
+	const __m128 cx = _mm_set1_ps(center._x), cy = _mm_set1_ps(center._y), cz = _mm_set1_ps(center._z);
+	const __m128 ex = _mm_set1_ps(extent._x), ey = _mm_set1_ps(extent._y), ez = _mm_set1_ps(extent._z);
+	const __m128 zero = _mm_setzero_ps();
+
+	int outsideMask = 0, insideMask = 0;
+	for (size_t i = 0; i < _planesX.size(); i += 4)
+	{
+		const __m128 px = _mm_load_ps(_planesX.data() + i);
+		const __m128 py = _mm_load_ps(_planesY.data() + i);
+		const __m128 pz = _mm_load_ps(_planesZ.data() + i);
+		const __m128 pw = _mm_load_ps(_planesW.data() + i);
+
+		__m128 distance = _mm_add_ps(_mm_mul_ps(px, cx), pw);
+		distance = _mm_add_ps(_mm_mul_ps(py, cy), distance);
+		distance = _mm_add_ps(_mm_mul_ps(pz, cz), distance);
+
+		__m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, px), ex);
+		radius = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, py), ey), radius);
+		radius = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, pz), ez), radius);
+
+		outsideMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		insideMask |= _mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(distance, radius), zero)) << i;
+	}
+
+	if (outsideMask != 0)
+	{
+		return intersection::outside;
+	}
+	return insideMask == 0xFF ? intersection::inside : intersection::intersects;
+#else
+	return classifyScalar(box);
+#endif
+}
+
+de::math::frustum::intersection de::math::frustum::classifyScalar(const aabb& box) const
+{
+	if (!box.isValid())
+	{
+		return intersection::outside;
+	}
+
+	const vec3 center = box.getCenter();
+	const vec3 extent = box.getExtent();
+
+	bool inside = true;
+	for (const auto& plane : _planes)
+	{
+		// summed in the same order as simd lanes, so both round the same way
+		const float distance = plane._x * center._x + plane._w + plane._y * center._y + plane._z * center._z;
+		const float radius = std::abs(plane._x) * extent._x + std::abs(plane._y) * extent._y + std::abs(plane._z) * extent._z;
+		if (distance + radius < 0.F)
+		{
+			return intersection::outside;
+		}
+		inside &= distance - radius >= 0.F;
+	}
+	return inside ? intersection::inside : intersection::intersects;
+}
\ No newline at end of file
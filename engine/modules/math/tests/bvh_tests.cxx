@@ -0,0 +1,177 @@
+#include "math/aabb.hxx"
+#include "math/bvh.hxx"
+#include "math/casts.hxx"
+#include "math/frustum.hxx"
+#include "math/mat4.hxx"
+#include "test/test.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using de::test::check;
+
+	std::vector<de::math::aabb> makeItems(size_t count, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> position(-200.F, 200.F);
+		std::uniform_real_distribution<float> halfSize(0.1F, 4.F);
+
+		std::vector<de::math::aabb> items;
+		items.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const de::math::vec3 center(position(rng), position(rng), position(rng));
+			const float size = halfSize(rng);
+			const de::math::vec3 extent(size, size, size);
+			items.emplace_back(center - extent, center + extent);
+		}
+		return items;
+	}
+
+	std::vector<de::math::frustum> makeFrustums(size_t count, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> position(-150.F, 150.F);
+
+		const auto proj = de::math::mat4::makeProjection(0.1F, 1000.F, 16.F / 9.F, de::math::deg_to_rad(75.F));
+
+		std::vector<de::math::frustum> frustums;
+		frustums.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const de::math::vec3 pos(position(rng), position(rng), position(rng));
+			const de::math::vec3 target(position(rng), position(rng), position(rng));
+			const auto view = de::math::mat4::lookAt(pos, target, de::math::vec3(0.F, 1.F, 0.F));
+			frustums.push_back(de::math::frustum::makeFromViewProjection(view * proj));
+		}
+		return frustums;
+	}
+
+	std::vector<uint32_t> queryTree(const de::math::bvh& tree, const de::math::frustum& frustum)
+	{
+		std::vector<uint32_t> visible;
+		tree.query(frustum, [&visible](uint32_t item)
+			{ visible.push_back(item); });
+		std::sort(visible.begin(), visible.end());
+		return visible;
+	}
+
+	std::vector<uint32_t> queryBruteForce(const std::vector<de::math::aabb>& items, const de::math::frustum& frustum)
+	{
+		std::vector<uint32_t> visible;
+		for (uint32_t i = 0; i < items.size(); ++i)
+		{
+			if (frustum.isVisible(items[i]))
+			{
+				visible.push_back(i);
+			}
+		}
+		return visible;
+	}
+
+	void testEmptyTree()
+	{
+		de::math::bvh tree;
+		tree.build({});
+		check(tree.isEmpty(), "tree of no items is empty");
+
+		bool called = false;
+		tree.query(makeFrustums(1, 1)[0], [&called](uint32_t)
+			{ called = true; });
+		check(!called, "empty tree reports no items");
+	}
+
+	void testSingleLeaf()
+	{
+		const auto items = makeItems(3, 2);
+
+		de::math::bvh tree;
+		tree.build(items, 4);
+		check(tree.getNodes().size() == 1, "items within leaf size make single node");
+		check(tree.getNodes()[0]._firstChild == 0 && tree.getNodes()[0]._itemCount == 3, "single node is leaf of every item");
+
+		// frustum around every item, and one looking away from all of them
+		const auto proj = de::math::mat4::makeProjection(0.1F, 1000.F, 1.F, de::math::deg_to_rad(75.F));
+		const auto inside = de::math::frustum::makeFromViewProjection(de::math::mat4::lookAt(de::math::vec3(0.F, 0.F, 600.F), de::math::vec3(), de::math::vec3(0.F, 1.F, 0.F)) * proj);
+		check(queryTree(tree, inside) == queryBruteForce(items, inside), "single leaf query matches brute force");
+
+		for (const auto& frustum : makeFrustums(64, 3))
+		{
+			check(queryTree(tree, frustum) == queryBruteForce(items, frustum), "single leaf query matches brute force for random frustum");
+		}
+	}
+
+	void testQueryMatchesBruteForce()
+	{
+		const auto items = makeItems(5000, 4);
+		const auto frustums = makeFrustums(64, 5);
+
+		for (const uint32_t leafItems : {1U, 4U, 16U})
+		{
+			de::math::bvh tree;
+			tree.build(items, leafItems);
+
+			uint32_t mismatches{};
+			size_t visibleTotal{};
+			for (const auto& frustum : frustums)
+			{
+				const auto expected = queryBruteForce(items, frustum);
+				mismatches += queryTree(tree, frustum) != expected;
+				visibleTotal += expected.size();
+			}
+			check(mismatches == 0, "tree query matches brute force");
+			check(visibleTotal != 0 && visibleTotal != items.size() * frustums.size(), "random frustums see some items but not all");
+		}
+	}
+
+	// time per frustum of tree query against testing every item
+	void benchmarkQuery()
+	{
+		const auto items = makeItems(100000, 6);
+		const auto frustums = makeFrustums(64, 7);
+
+		de::math::bvh tree;
+		const auto buildStart = std::chrono::steady_clock::now();
+		tree.build(items);
+		const auto buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+		size_t treeVisible{}, bruteVisible{};
+		const auto treeStart = std::chrono::steady_clock::now();
+		for (const auto& frustum : frustums)
+		{
+			tree.query(frustum, [&treeVisible](uint32_t)
+				{ ++treeVisible; });
+		}
+		const auto treeTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - treeStart).count();
+
+		const auto bruteStart = std::chrono::steady_clock::now();
+		for (const auto& frustum : frustums)
+		{
+			for (const auto& item : items)
+			{
+				bruteVisible += frustum.isVisible(item);
+			}
+		}
+		const auto bruteTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - bruteStart).count();
+
+		check(treeVisible == bruteVisible, "benchmark tree and brute force see the same items");
+		std::printf("bvh: %zu items built in %.1f ms, %zu nodes\n", items.size(), buildTime, tree.getNodes().size());
+		std::printf("bvh: query %.1f us per frustum, brute force %.1f us per frustum, %.1f visible on average\n",
+			treeTime / frustums.size(), bruteTime / frustums.size(), static_cast<double>(treeVisible) / frustums.size());
+	}
+} // namespace
+
+int main()
+{
+	testEmptyTree();
+	testSingleLeaf();
+	testQueryMatchesBruteForce();
+	benchmarkQuery();
+
+	return de::test::result();
+}
\ No newline at end of file
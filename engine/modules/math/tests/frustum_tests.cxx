@@ -0,0 +1,71 @@
+#include "math/aabb.hxx"
+#include "math/casts.hxx"
+#include "math/frustum.hxx"
+#include "math/mat4.hxx"
+#include "test/test.hxx"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+	using de::test::check;
+	using intersection = de::math::frustum::intersection;
+
+	de::math::aabb makeBox(const de::math::vec3& center, float halfSize)
+	{
+		const de::math::vec3 extent(halfSize, halfSize, halfSize);
+		return de::math::aabb(center - extent, center + extent);
+	}
+
+	de::math::frustum makeFrustum(const de::math::vec3& pos, const de::math::vec3& target)
+	{
+		const auto view = de::math::mat4::lookAt(pos, target, de::math::vec3(0.F, 1.F, 0.F));
+		const auto proj = de::math::mat4::makeProjection(0.1F, 100.F, 16.F / 9.F, de::math::deg_to_rad(75.F));
+		return de::math::frustum::makeFromViewProjection(view * proj);
+	}
+
+	void testKnownBoxes()
+	{
+		const auto frustum = makeFrustum(de::math::vec3(0.F, 0.F, 0.F), de::math::vec3(0.F, 0.F, -1.F));
+
+		check(frustum.classify(makeBox(de::math::vec3(0.F, 0.F, -10.F), 1.F)) == intersection::inside, "box in front of camera inside");
+		check(frustum.classify(makeBox(de::math::vec3(0.F, 0.F, 10.F), 1.F)) == intersection::outside, "box behind camera outside");
+		check(frustum.classify(makeBox(de::math::vec3(0.F, 0.F, -10.F), 20.F)) == intersection::intersects, "box around camera intersects");
+		check(frustum.classify(makeBox(de::math::vec3(1000.F, 0.F, -10.F), 1.F)) == intersection::outside, "box far to the side outside");
+		check(frustum.classify(de::math::aabb()) == intersection::outside, "empty box outside");
+		check(frustum.classifyScalar(de::math::aabb()) == intersection::outside, "empty box outside without simd");
+	}
+
+	// simd lanes padded with planes every point is inside of, so result must match plane by plane test
+	void testSimdMatchesScalar()
+	{
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<float> position(-60.F, 60.F);
+		std::uniform_real_distribution<float> halfSize(0.F, 8.F);
+
+		uint32_t mismatches{};
+		std::array<uint32_t, 3> results{};
+		for (int f = 0; f < 32; ++f)
+		{
+			const auto frustum = makeFrustum(de::math::vec3(position(rng), position(rng), position(rng)), de::math::vec3(position(rng), position(rng), position(rng)));
+			for (int i = 0; i < 4096; ++i)
+			{
+				const auto box = makeBox(de::math::vec3(position(rng), position(rng), position(rng)), halfSize(rng));
+				const auto simd = frustum.classify(box);
+				mismatches += simd != frustum.classifyScalar(box);
+				++results[static_cast<size_t>(simd)];
+			}
+		}
+		check(mismatches == 0, "simd classify matches scalar classify");
+		check(results[0] != 0 && results[1] != 0 && results[2] != 0, "random boxes cover every intersection result");
+	}
+} // namespace
+
+int main()
+{
+	testKnownBoxes();
+	testSimdMatchesScalar();
+
+	return de::test::result();
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "math/aabb.hxx"
+#include "math/constants.hxx"
+#include "math/mat4.hxx"
+#include "math/quaternion.hxx"
+#include "test/test.hxx"
+
+#include <cmath>
+
+namespace
+{
+	using de::test::check;
+
+	bool nearlyEqual(const de::math::vec3& a, const de::math::vec3& b)
+	{
+		constexpr float eps = 1e-5F;
+		return std::abs(a._x - b._x) < eps && std::abs(a._y - b._y) < eps && std::abs(a._z - b._z) < eps;
+	}
+
+	de::math::vec3 transformPoint(const de::math::mat4& mat, const de::math::vec3& point)
+	{
+		return de::math::aabb(point, point).transform(mat).getCenter();
+	}
+
+	// a * b applies a first, so view * proj transforms to view space and then to clip space
+	void testMultiplyOrder()
+	{
+		const auto translate = de::math::mat4::makeTranslation(de::math::vec3(1.F, 0.F, 0.F));
+		const auto scale = de::math::mat4::makeScale(de::math::vec3(2.F, 2.F, 2.F));
+
+		const de::math::vec3 origin{};
+		check(nearlyEqual(transformPoint(translate * scale, origin), de::math::vec3(2.F, 0.F, 0.F)), "translate * scale scales translated point");
+		check(nearlyEqual(transformPoint(scale * translate, origin), de::math::vec3(1.F, 0.F, 0.F)), "scale * translate translates scaled point");
+	}
+
+	// gpu instancing transform is in node local space, so instance applied before node
+	void testNodeRotationWithInstanceTranslation()
+	{
+		const auto rotation = de::math::quaternion::from_axis_angle(de::math::vec3(0.F, 0.F, 1.F), static_cast<float>(de::math::Pi) * 0.5F);
+		const auto nodeMat = de::math::mat4::makeRotation(rotation) * de::math::mat4::makeTranslation(de::math::vec3(0.F, 0.F, 5.F));
+		const auto instanceMat = de::math::mat4::makeTranslation(de::math::vec3(1.F, 0.F, 0.F));
+
+		const de::math::vec3 origin{};
+		const auto rotatedOffset = transformPoint(nodeMat, de::math::vec3(1.F, 0.F, 0.F));
+		const auto instanced = transformPoint(instanceMat * nodeMat, origin);
+
+		check(nearlyEqual(instanced, rotatedOffset), "instance translation rotated by node");
+		check(!nearlyEqual(instanced, de::math::vec3(1.F, 0.F, 5.F)), "instance translation not left unrotated");
+		check(std::abs(instanced._x) < 1e-5F && std::abs(std::abs(instanced._y) - 1.F) < 1e-5F, "offset along x rotated onto y axis");
+	}
+} // namespace
+
+int main()
+{
+	testMultiplyOrder();
+	testNodeRotationWithInstanceTranslation();
+
+	return de::test::result();
+}
\ No newline at end of file
@@ -22,6 +22,8 @@ static bool isStemShaderSource(const std::string_view& stem)
 		return true;
 	else if (".geom" == stem)
 		return true;
+	else if (".comp" == stem)
+		return true;
 
 	return false;
 }
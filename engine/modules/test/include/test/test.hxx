@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdio>
+
+namespace de::test
+{
+	// failed checks of test executable
+	inline int failures{};
+
+	inline void check(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", what);
+			++failures;
+		}
+	}
+
+	// exit code of test executable, returned from main once every test ran
+	inline int result()
+	{
+		if (failures != 0)
+		{
+			std::printf("%d checks failed\n", failures);
+			return 1;
+		}
+		std::printf("all checks passed\n");
+		return 0;
+	}
+} // namespace de::test
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "thread_task.hxx"
 
 #include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <string_view>
@@ -48,6 +50,10 @@ namespace de::async
 		template <typename Task>
 		thread_task::shared queueTask(Task&& task);
 
+		// runs func for every index in [0, count) on pool threads and calling thread, returns once all done.
+		// index executed by single thread, so resources indexed by it need no locking
+		void parallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
 		void setCleanupFrame(uint64_t inValue);
 
 		bool getLoopCondition() const;
@@ -66,11 +72,34 @@ namespace de::async
 		thread_task* beginTaskProcessing();
 		void endProcessingTask(thread_task* task);
 
+		struct parallel_job
+		{
+			const std::function<void(uint32_t)>* _func{};
+			uint32_t _count{};
+			std::atomic<uint32_t> _next{};
+
+			// threads that could still run indices of the job
+			uint32_t _users{};
+		};
+
+		// run indices of current parallel job, returns false if no job
+		bool runParallelJob();
+		void runParallelIndices(parallel_job& job);
+
+		void waitForWork();
+
 		std::mutex _tasksMutex{};
 		std::map<thread_task::shared, std::atomic<task_state>> _tasks{};
 
 		std::vector<SDL_Thread*> _threads{};
 
+		// serializes parallelFor callers
+		std::mutex _parallelForMutex{};
+
+		std::mutex _parallelMutex{};
+		std::condition_variable _parallelCondition{};
+		parallel_job* _parallelJob{};
+
 		uint64_t _totalTaskCount{};
 
 		uint64_t _cleanupFrame{5000};
@@ -85,6 +85,68 @@ void de::async::thread_pool::tick(uint64_t frameCount)
 	}
 }
 
+void de::async::thread_pool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+{
+	if (count == 0)
+		return;
+
+	std::scoped_lock<std::mutex> parallelForGuard(_parallelForMutex);
+
+	parallel_job job;
+	job._func = &func;
+	job._count = count;
+	{
+		std::scoped_lock<std::mutex> lock(_parallelMutex);
+		_parallelJob = &job;
+	}
+	_parallelCondition.notify_all();
+
+	runParallelIndices(job);
+
+	// every index taken, wait for threads still executing theirs
+	std::unique_lock<std::mutex> lock(_parallelMutex);
+	_parallelJob = nullptr;
+	_parallelCondition.wait(lock, [&job]()
+		{ return job._users == 0; });
+}
+
+bool de::async::thread_pool::runParallelJob()
+{
+	parallel_job* job{};
+	{
+		std::scoped_lock<std::mutex> lock(_parallelMutex);
+		job = _parallelJob;
+		if (job == nullptr || job->_next >= job->_count)
+			return false;
+		++job->_users;
+	}
+
+	runParallelIndices(*job);
+
+	{
+		std::scoped_lock<std::mutex> lock(_parallelMutex);
+		--job->_users;
+	}
+	_parallelCondition.notify_all();
+	return true;
+}
+
+void de::async::thread_pool::runParallelIndices(parallel_job& job)
+{
+	for (uint32_t index = job._next++; index < job._count; index = job._next++)
+	{
+		(*job._func)(index);
+	}
+}
+
+void de::async::thread_pool::waitForWork()
+{
+	// woken by parallelFor, tasks still polled
+	std::unique_lock<std::mutex> lock(_parallelMutex);
+	_parallelCondition.wait_for(lock, std::chrono::milliseconds(3), [this]()
+		{ return !getLoopCondition() || (_parallelJob != nullptr && _parallelJob->_next < _parallelJob->_count); });
+}
+
 uint32_t de::async::thread_pool::hardwareConcurrency()
 {
 	return static_cast<uint32_t>(std::thread::hardware_concurrency());
@@ -113,6 +175,11 @@ int de::async::thread_pool::threadsLoop(void* data)
 
 	while (pool.getLoopCondition())
 	{
+		if (pool.runParallelJob())
+		{
+			continue;
+		}
+
 		if (auto task = pool.beginTaskProcessing())
 		{
 			if (task)
@@ -124,7 +191,7 @@ int de::async::thread_pool::threadsLoop(void* data)
 		}
 		else
 		{
-			std::this_thread::sleep_for(std::chrono::milliseconds(3));
+			pool.waitForWork();
 		}
 	}
 	return 0;
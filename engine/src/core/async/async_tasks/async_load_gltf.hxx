@@ -12,20 +12,22 @@ namespace de::async
 	{
 		using callback = std::function<void(const de::gltf::model&)>;
 
-		async_load_gltf(const std::string_view sceneUri)
+		async_load_gltf(const std::string_view sceneUri, bool loadImages = true)
 			: _file(sceneUri)
+			, _loadImages{loadImages}
 		{
 		}
 
 		virtual void doJob() override
 		{
-			_model = de::gltf::loadModel(_file);
+			_model = de::gltf::loadModel(_file, _loadImages);
 		}
 
 		de::gltf::model extract() { return std::move(_model); };
 
 	private:
 		std::string _file;
+		bool _loadImages{true};
 		de::gltf::model _model;
 	};
 } // namespace de::async
\ No newline at end of file
@@ -1,29 +1,29 @@
 #pragma once
-#include "core/async/thread_pool.hxx"
-#include "core/containers/image_data.hxx"
+#include "gltf/gltf.hxx"
+#include "gltf/image.hxx"
+#include "threads/thread_pool.hxx"
 
-#include <string_view>
+#include <string>
 
 namespace de::async
 {
 	struct async_load_image : public thread_task
 	{
-		async_load_texture_task(const std::string_view imageUri)
+		async_load_image(const std::string_view imageUri)
 			: _imageUri(imageUri)
-			, _image{}
 		{
 		}
 
 		virtual void doJob() override
 		{
-			_image.load(_imageUri);
+			_image = de::gltf::loadImage(_imageUri);
 		};
 
-		image_data extract() { return std::move(_image); };
+		de::gltf::image extract() { return std::move(_image); };
 
 	private:
 		std::string _imageUri;
 
-		image_data _image;
+		de::gltf::image _image;
 	};
-} // namespace de::async
\ No newline at end of file
+} // namespace de::async
@@ -241,6 +241,8 @@ bool de::engine::startRenderer()
 void de::engine::preMainLoop()
 {
 	_gameInstance->init();
+
+	_frameTimeCapture.initFromEnvironment();
 }
 
 void de::engine::startMainLoop()
@@ -256,14 +258,18 @@ void de::engine::startMainLoop()
 			continue; // skip tick if delta time zero
 		}
 		++_frameCounter;
-		_fpsCounter.tick(deltaTime);
 
 		_eventManager.tick();
 		_threadPool.tick(_frameCounter);
 
 		_gameInstance->tick(deltaTime);
 
+		const auto renderStart = std::chrono::steady_clock::now();
 		_renderer.tick(deltaTime);
+		const double renderTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+
+		_fpsCounter.tick(deltaTime, renderTime);
+		_frameTimeCapture.tick(deltaTime, renderTime);
 	}
 
 	postMainLoop();
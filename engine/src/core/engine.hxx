@@ -2,6 +2,7 @@
 #include "core/managers/event_manager.hxx"
 #include "core/managers/input_manager.hxx"
 #include "core/misc/fps_counter.hxx"
+#include "core/misc/frame_time_capture.hxx"
 #include "game_framework/game_instance.hxx"
 #include "renderer/render.hxx"
 #include "threads/thread_pool.hxx"
@@ -84,6 +85,8 @@ namespace de
 
 		de::misc::fps_counter _fpsCounter;
 
+		de::misc::frame_time_capture _frameTimeCapture;
+
 		bool _isRunning{};
 	};
 } // namespace de
\ No newline at end of file
@@ -30,3 +30,37 @@ std::string de::file::read(const std::string_view path)
 	}
 	return std::string();
 }
+
+bool de::file::write(const std::string_view path, const std::string_view content)
+{
+	// string_view may not be null terminated, logged path needs its own string
+	const std::string pathString(path);
+	const std::filesystem::path filePath(pathString);
+	std::filesystem::path tempPath(filePath);
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ofstream::binary | std::ofstream::trunc);
+		if (!file.is_open())
+		{
+			DE_LOG(Error, "%s: failed to open file: %s", __FUNCTION__, tempPath.generic_string().c_str());
+			return false;
+		}
+		file.write(content.data(), content.size());
+		if (!file.good())
+		{
+			DE_LOG(Error, "%s: failed to write file: %s", __FUNCTION__, tempPath.generic_string().c_str());
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, filePath, error);
+	if (error)
+	{
+		DE_LOG(Error, "%s: failed to replace file: %s, %s", __FUNCTION__, pathString.c_str(), error.message().c_str());
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	DE_LOG(Verbose, "%s: written %zu bytes to: %s", __FUNCTION__, content.size(), pathString.c_str());
+	return true;
+}
\ No newline at end of file
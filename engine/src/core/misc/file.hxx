@@ -7,4 +7,7 @@
 namespace de::file
 {
 	DRECO_API std::string read(const std::string_view path);
+
+	// replaces file content, written to temporary file first so failed write never leaves partial file
+	DRECO_API bool write(const std::string_view path, const std::string_view content);
 }
\ No newline at end of file
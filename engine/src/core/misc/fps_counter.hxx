@@ -2,26 +2,52 @@
 
 #include "dreco.hxx"
 
+#include <algorithm>
+#include <limits>
+
 namespace de::misc
 {
+	// logs fps and frame time once per reset time, frame time split to whole frame and renderer tick on cpu
 	struct fps_counter
 	{
 		fps_counter() = default;
-		void tick(double deltaTime)
+
+		// called once renderer ticked, so report covers render time of the same frames it counts
+		void tick(double deltaTime, double renderTime)
 		{
+			++_counter;
+			_frameTimeSum += deltaTime;
+			_frameTimeMin = std::min(_frameTimeMin, deltaTime);
+			_frameTimeMax = std::max(_frameTimeMax, deltaTime);
+			_renderTimeSum += renderTime;
+			_renderTimeMax = std::max(_renderTimeMax, renderTime);
+
 			_time -= deltaTime;
 			if (_time <= 0.F)
 			{
-				DE_LOG(Info, "%s: %i", __FUNCTION__, _counter);
-				_time = _resetTime - _time;
+				DE_LOG(Info, "%s: %llu fps, frame avg %.2f ms, min %.2f ms, max %.2f ms, renderer avg %.2f ms, max %.2f ms", __FUNCTION__, static_cast<unsigned long long>(_counter),
+					_frameTimeSum / _counter * 1000.0, _frameTimeMin * 1000.0, _frameTimeMax * 1000.0,
+					_renderTimeSum / _counter * 1000.0, _renderTimeMax * 1000.0);
+				_time = _resetTime + _time;
 				_counter = 0;
+				_frameTimeSum = 0.0;
+				_frameTimeMin = std::numeric_limits<double>::max();
+				_frameTimeMax = 0.0;
+				_renderTimeSum = 0.0;
+				_renderTimeMax = 0.0;
 			}
-			++_counter;
 		}
 
 	private:
 		const double _resetTime{1.f};
 		double _time{_resetTime};
 		uint64_t _counter{};
+
+		double _frameTimeSum{};
+		double _frameTimeMin{std::numeric_limits<double>::max()};
+		double _frameTimeMax{};
+
+		double _renderTimeSum{};
+		double _renderTimeMax{};
 	};
 } // namespace de::misc
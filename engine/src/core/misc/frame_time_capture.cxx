@@ -0,0 +1,166 @@
+#include "frame_time_capture.hxx"
+
+#include "core/misc/file.hxx"
+#include "log/log.hxx"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <sstream>
+
+void de::misc::frame_time_capture::initFromEnvironment()
+{
+	const char* frames = std::getenv("DRECO_FRAME_CAPTURE");
+	if (frames == nullptr)
+		return;
+
+	const char* baseline = std::getenv("DRECO_FRAME_CAPTURE_BASELINE");
+	start(static_cast<uint32_t>(std::strtoul(frames, nullptr, 10)), "frame_times.csv", baseline != nullptr ? baseline : "");
+}
+
+void de::misc::frame_time_capture::start(uint32_t frameCount, const std::string_view outPath, const std::string_view baselinePath)
+{
+	if (frameCount == 0)
+	{
+		DE_LOG(Error, "%s: frame count of capture is zero", __FUNCTION__);
+		return;
+	}
+
+	_frameCount = frameCount;
+	_skippedFrames = 0;
+	_samples.clear();
+	_samples.reserve(frameCount);
+	_outPath = outPath;
+	_baselinePath = baselinePath;
+	DE_LOG(Info, "%s: capturing %u frames after %u warmup frames to: %s", __FUNCTION__, _frameCount, _warmupFrames, _outPath.c_str());
+}
+
+void de::misc::frame_time_capture::tick(double frameTime, double renderTime)
+{
+	if (!isCapturing())
+		return;
+
+	if (_skippedFrames < _warmupFrames)
+	{
+		++_skippedFrames;
+		return;
+	}
+
+	_samples.push_back(sample{._frameTime = frameTime, ._renderTime = renderTime});
+	if (_samples.size() == _frameCount)
+	{
+		finish();
+	}
+}
+
+void de::misc::frame_time_capture::finish()
+{
+	_frameCount = 0;
+
+	std::vector<double> frameTimes(_samples.size());
+	std::vector<double> renderTimes(_samples.size());
+	std::transform(_samples.begin(), _samples.end(), frameTimes.begin(), [](const sample& s)
+		{ return s._frameTime; });
+	std::transform(_samples.begin(), _samples.end(), renderTimes.begin(), [](const sample& s)
+		{ return s._renderTime; });
+	const stats frameStats = makeStats(std::move(frameTimes));
+	const stats renderStats = makeStats(std::move(renderTimes));
+
+	DE_LOG(Info, "%s: captured %zu frames", __FUNCTION__, _samples.size());
+	logStats("frame", frameStats);
+	logStats("renderer", renderStats);
+
+	de::file::write(_outPath, toCsv(_samples));
+
+	if (_baselinePath.empty())
+		return;
+
+	const auto baseline = fromCsv(de::file::read(_baselinePath));
+	if (baseline.empty())
+	{
+		DE_LOG(Error, "%s: baseline has no samples: %s", __FUNCTION__, _baselinePath.c_str());
+		return;
+	}
+
+	std::vector<double> baselineFrameTimes(baseline.size());
+	std::vector<double> baselineRenderTimes(baseline.size());
+	std::transform(baseline.begin(), baseline.end(), baselineFrameTimes.begin(), [](const sample& s)
+		{ return s._frameTime; });
+	std::transform(baseline.begin(), baseline.end(), baselineRenderTimes.begin(), [](const sample& s)
+		{ return s._renderTime; });
+
+	DE_LOG(Info, "%s: compared with %zu frames of: %s", __FUNCTION__, baseline.size(), _baselinePath.c_str());
+	logComparison("frame", makeStats(std::move(baselineFrameTimes)), frameStats);
+	logComparison("renderer", makeStats(std::move(baselineRenderTimes)), renderStats);
+}
+
+de::misc::frame_time_capture::stats de::misc::frame_time_capture::makeStats(std::vector<double> times)
+{
+	if (times.empty())
+		return stats();
+
+	std::sort(times.begin(), times.end());
+	const auto percentile = [&times](double p)
+	{
+		return times[std::min(times.size() - 1, static_cast<size_t>(p * times.size()))];
+	};
+
+	return stats{
+		._avg = std::accumulate(times.begin(), times.end(), 0.0) / times.size(),
+		._p50 = percentile(0.5),
+		._p95 = percentile(0.95),
+		._p99 = percentile(0.99),
+		._max = times.back()};
+}
+
+std::string de::misc::frame_time_capture::toCsv(const std::vector<sample>& samples)
+{
+	std::string out = "frame_ms,renderer_ms\n";
+	char line[64];
+	for (const auto& s : samples)
+	{
+		std::snprintf(line, sizeof(line), "%.4f,%.4f\n", s._frameTime * 1000.0, s._renderTime * 1000.0);
+		out += line;
+	}
+	return out;
+}
+
+std::vector<de::misc::frame_time_capture::sample> de::misc::frame_time_capture::fromCsv(const std::string& csv)
+{
+	std::vector<sample> out;
+	std::istringstream stream(csv);
+	std::string line;
+
+	// header
+	std::getline(stream, line);
+	while (std::getline(stream, line))
+	{
+		double frameMs{}, renderMs{};
+		if (std::sscanf(line.c_str(), "%lf,%lf", &frameMs, &renderMs) == 2)
+		{
+			out.push_back(sample{._frameTime = frameMs / 1000.0, ._renderTime = renderMs / 1000.0});
+		}
+	}
+	return out;
+}
+
+void de::misc::frame_time_capture::logStats(const char* name, const stats& current)
+{
+	DE_LOG(Info, "%s: %s avg %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms", __FUNCTION__, name,
+		current._avg * 1000.0, current._p50 * 1000.0, current._p95 * 1000.0, current._p99 * 1000.0, current._max * 1000.0);
+}
+
+void de::misc::frame_time_capture::logComparison(const char* name, const stats& baseline, const stats& current)
+{
+	const auto change = [](double before, double after)
+	{
+		return before > 0.0 ? (after - before) / before * 100.0 : 0.0;
+	};
+
+	DE_LOG(Info, "%s: %s avg %.3f -> %.3f ms (%+.1f%%), p50 %.3f -> %.3f ms (%+.1f%%), p95 %.3f -> %.3f ms (%+.1f%%), p99 %.3f -> %.3f ms (%+.1f%%)", __FUNCTION__, name,
+		baseline._avg * 1000.0, current._avg * 1000.0, change(baseline._avg, current._avg),
+		baseline._p50 * 1000.0, current._p50 * 1000.0, change(baseline._p50, current._p50),
+		baseline._p95 * 1000.0, current._p95 * 1000.0, change(baseline._p95, current._p95),
+		baseline._p99 * 1000.0, current._p99 * 1000.0, change(baseline._p99, current._p99));
+}
\ No newline at end of file
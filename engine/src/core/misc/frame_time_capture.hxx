@@ -0,0 +1,63 @@
+#pragma once
+
+#include "dreco.hxx"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace de::misc
+{
+	// records frame time and renderer tick cpu time of fixed frame count, to compare frame time before and after a change.
+	// samples saved as csv, capture of build before the change passed as baseline gets its stats logged side by side
+	class DRECO_API frame_time_capture
+	{
+	public:
+		// DRECO_FRAME_CAPTURE=<frames> starts capture, DRECO_FRAME_CAPTURE_BASELINE=<csv> compares with previous capture
+		void initFromEnvironment();
+
+		// frames loading scene and compiling pipelines skipped before capture starts
+		void start(uint32_t frameCount, const std::string_view outPath, const std::string_view baselinePath);
+
+		void tick(double frameTime, double renderTime);
+
+		bool isCapturing() const { return _frameCount != 0; }
+
+	private:
+		struct sample
+		{
+			double _frameTime{};
+			double _renderTime{};
+		};
+
+		struct stats
+		{
+			double _avg{};
+			double _p50{};
+			double _p95{};
+			double _p99{};
+			double _max{};
+		};
+
+		void finish();
+
+		static stats makeStats(std::vector<double> times);
+
+		static std::string toCsv(const std::vector<sample>& samples);
+
+		static std::vector<sample> fromCsv(const std::string& csv);
+
+		static void logStats(const char* name, const stats& current);
+
+		static void logComparison(const char* name, const stats& baseline, const stats& current);
+
+		static constexpr uint32_t _warmupFrames{120};
+
+		uint32_t _frameCount{};
+		uint32_t _skippedFrames{};
+		std::vector<sample> _samples;
+
+		std::string _outPath;
+		std::string _baselinePath;
+	};
+} // namespace de::misc
\ No newline at end of file
@@ -1,24 +1,140 @@
 #include "gltf_model.hxx"
 
 #include "core/async/async_tasks/async_load_gltf.hxx"
+#include "core/async/async_tasks/async_load_image.hxx"
 #include "core/engine.hxx"
 
+de::gf::gltf_model::~gltf_model()
+{
+	// model destroyed before its loads completed, so they must not call back into it
+	for (const auto& task : _loadTasks)
+	{
+		task->unbindAll();
+		task->abort();
+	}
+}
+
 void de::gf::gltf_model::init()
 {
 	node::init();
 
-	auto task = de::engine::get()->getThreadPool().queueTask<de::async::async_load_gltf>(DRECO_ASSET(_modelPath));
+	// images streamed separately, so geometry could be drawn with placeholders sooner
+	auto task = de::engine::get()->getThreadPool().queueTask<de::async::async_load_gltf>(DRECO_ASSET(_modelPath), false);
 	task->bindCallback(this, &gltf_model::onModelLoaded);
+	_loadTasks.push_back(task);
 }
 
 void de::gf::gltf_model::onModelLoaded(de::async::thread_task* task)
 {
 	auto loadGltfTask = dynamic_cast<de::async::async_load_gltf*>(task);
+	releaseLoadTask(task);
 	if (auto* eng = de::engine::get())
 	{
 		_model = loadGltfTask->extract();
 
 		auto& renderer = eng->getRenderer();
-		renderer.loadModel(_model);
+		_scene = renderer.loadModel(_model);
+
+		auto& threadPool = eng->getThreadPool();
+		const uint32_t imagesNum = _model._images.size();
+		for (uint32_t i = 0; i < imagesNum; ++i)
+		{
+			auto imageTask = threadPool.queueTask<de::async::async_load_image>(_model._rootPath + '/' + _model._images[i]._uri);
+			imageTask->bindCallback([this, i](de::async::thread_task* task)
+				{ onImageLoaded(i, task); });
+			_loadTasks.push_back(imageTask);
+		}
+		_pendingImages = imagesNum;
+
+		_uploadedSize = _model.getMemoryUsage();
+		if (_residency == residency::drop_after_upload)
+		{
+			_model = de::gltf::model();
+		}
+		else if (_residency == residency::bounds_proxy)
+		{
+			_model.releaseMeshesData();
+		}
+		_releasedSize = _uploadedSize - _model.getMemoryUsage();
+
+		if (_pendingImages == 0)
+		{
+			logMemoryUsage();
+		}
+	}
+}
+
+void de::gf::gltf_model::onImageLoaded(uint32_t index, de::async::thread_task* task)
+{
+	auto loadImageTask = dynamic_cast<de::async::async_load_image*>(task);
+	releaseLoadTask(task);
+	if (_scene)
+	{
+		auto image = loadImageTask->extract();
+		_scene->setTextureImage(index, image);
+
+		_uploadedSize += image._pixels.capacity();
+		if (_residency == residency::keep_cpu)
+		{
+			_model._images[index] = std::move(image);
+		}
+		else
+		{
+			_releasedSize += image._pixels.capacity();
+		}
+
+		if (--_pendingImages == 0)
+		{
+			logMemoryUsage();
+		}
+	}
+}
+
+void de::gf::gltf_model::releaseLoadTask(de::async::thread_task* task)
+{
+	std::erase_if(_loadTasks, [task](const std::shared_ptr<de::async::thread_task>& loadTask)
+		{ return loadTask.get() == task; });
+}
+
+void de::gf::gltf_model::logMemoryUsage() const
+{
+	DE_LOG(Info, "%s: %s uploaded %zu KB, released %zu KB, kept on cpu %zu KB", __FUNCTION__, _modelPath.data(), _uploadedSize / 1024, _releasedSize / 1024, _model.getMemoryUsage() / 1024);
+}
+
+static void recurseNodesBounds(const de::gltf::model& m, const de::gltf::node& selfNode, const de::math::transform& rootTransform, de::math::aabb& outBounds)
+{
+	const auto newTransform = selfNode._transform + rootTransform;
+	if (selfNode._mesh != UINT32_MAX)
+	{
+		const auto nodeMat = de::math::mat4::makeTransform(newTransform);
+		for (const auto& primitive : m._meshes[selfNode._mesh]._primitives)
+		{
+			if (selfNode._instances.empty())
+			{
+				outBounds.extend(primitive._bounds.transform(nodeMat));
+			}
+			// instance transform is in node local space, so applied before node one
+			for (const auto& instanceMat : selfNode._instances)
+			{
+				outBounds.extend(primitive._bounds.transform(instanceMat * nodeMat));
+			}
+		}
+	}
+	for (const auto childNodeIndex : selfNode._children)
+	{
+		recurseNodesBounds(m, m._nodes[childNodeIndex], newTransform, outBounds);
+	}
+}
+
+de::math::aabb de::gf::gltf_model::getBounds() const
+{
+	de::math::aabb bounds;
+	if (_model._sceneIndex < _model._scenes.size())
+	{
+		for (const auto nodeIndex : _model._scenes[_model._sceneIndex]._nodes)
+		{
+			recurseNodesBounds(_model, _model._nodes[nodeIndex], de::math::transform(), bounds);
+		}
 	}
+	return bounds;
 }
\ No newline at end of file
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "gltf/model.hxx"
+#include "math/aabb.hxx"
 
 #include "node.hxx"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace de
 {
@@ -13,25 +16,64 @@ namespace de
 		struct thread_task;
 	} // namespace async
 
+	namespace vulkan
+	{
+		class scene;
+	} // namespace vulkan
+
 	namespace gf
 	{
 		class DRECO_API gltf_model : public node
 		{
 		public:
+			// what happens with cpu side model data after it was uploaded to renderer
+			enum class residency : uint8_t
+			{
+				keep_cpu,		   // keep everything
+				drop_after_upload, // release all model data
+				bounds_proxy	   // keep nodes, materials and primitive bounds only
+			};
+
 			template <typename Str>
-			gltf_model(Str&& modelPath)
+			gltf_model(Str&& modelPath, residency inResidency = residency::bounds_proxy)
 				: _modelPath{modelPath}
+				, _residency{inResidency}
 			{
 			}
 
+			virtual ~gltf_model() override;
+
 			virtual void init() override;
 
+			const de::gltf::model& getModel() const { return _model; }
+
+			// bounds of model scene in model space, invalid if not loaded or dropped
+			de::math::aabb getBounds() const;
+
 		private:
 			void onModelLoaded(de::async::thread_task* task);
 
+			void onImageLoaded(uint32_t index, de::async::thread_task* task);
+
+			// task completed, its callback no longer needs to be unbound on destruction
+			void releaseLoadTask(de::async::thread_task* task);
+
+			void logMemoryUsage() const;
+
 			std::string _modelPath;
 
+			residency _residency;
+
 			de::gltf::model _model;
+
+			uint32_t _pendingImages{};
+			size_t _uploadedSize{};
+			size_t _releasedSize{};
+
+			de::vulkan::scene* _scene{};
+
+			// queued loads with callbacks bound to this model
+			std::vector<std::shared_ptr<de::async::thread_task>> _loadTasks;
 		};
 	} // namespace gf
 } // namespace de
\ No newline at end of file
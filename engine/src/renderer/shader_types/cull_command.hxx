@@ -0,0 +1,24 @@
+#pragma once
+#include "math/vec4.hxx"
+
+#include <cstdint>
+
+// mesh drawn by indirect command, element of std430 array read by culling compute shaders
+struct alignas(16) cull_command
+{
+	// mesh space bounds, w unused
+	de::math::vec4 _boundsCenter;
+	de::math::vec4 _boundsExtent;
+
+	uint32_t _indexCount{};
+	uint32_t _firstIndex{};
+	int32_t _vertexOffset{};
+
+	// objects of mesh instances laid out next to each other in scene objects buffer
+	uint32_t _firstObject{};
+
+	uint32_t _materialIndex{};
+
+	// first command of material, compacted commands of material written from it
+	uint32_t _materialFirstCommand{};
+};
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include "math/mat4.hxx"
+#include "math/vec2.hxx"
+#include "math/vec4.hxx"
+
+#include <array>
+#include <cstdint>
+
+// std140 uniform block of culling compute shader, written to slice of current view frame
+struct cull_data
+{
+	// frustum of current view projection
+	std::array<de::math::vec4, 6> _frustumPlanes{};
+
+	// hi-z pyramid built with previous frame view projection
+	de::math::mat4 _prevViewProj{de::math::mat4::makeIdentity()};
+
+	de::math::vec2 _hizSize{};
+	uint32_t _hizMipCount{};
+	uint32_t _occlusion{};
+};
\ No newline at end of file
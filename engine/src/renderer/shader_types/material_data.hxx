@@ -4,7 +4,10 @@
 #include "math/vec3.hxx"
 #include "math/vec4.hxx"
 
-struct material_data
+#include <cstdint>
+
+// element of std430 array, so size padded to 16 bytes alignment of vec4
+struct alignas(16) material_data
 {
 	material_data() = default;
 	material_data(const de::gltf::material& m);
@@ -20,4 +23,10 @@ struct material_data
 	float _metallicFactor{1.F};
 	float _roughnessFactor{1.F};
 	float _normalScale{1.F};
+
+	// slots in bindless heap, placeholder one until image uploaded
+	uint32_t _baseColorTexture{};
+	uint32_t _metallicRoughnessTexture{};
+	uint32_t _emissiveTexture{};
+	uint32_t _normalTexture{};
 };
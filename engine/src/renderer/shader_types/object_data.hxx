@@ -0,0 +1,15 @@
+#pragma once
+#include "math/mat4.hxx"
+
+#include <cstdint>
+
+// element of std430 array, so size padded to 16 bytes alignment of mat4
+struct alignas(16) object_data
+{
+	de::math::mat4 _model{de::math::mat4::makeIdentity()};
+
+	uint32_t _materialIndex{};
+
+	// scene indirect command drawing this object
+	uint32_t _commandIndex{};
+};
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "async_create_pipeline.hxx"
+
+#include "dreco.hxx"
+
+void de::vulkan::async_create_pipeline::link()
+{
+	_shaderStages = {_vert->getPipelineShaderStageCreateInfo(), _frag->getPipelineShaderStageCreateInfo()};
+
+	_vertexInputState
+		.setVertexBindingDescriptions(_vertexInputInfo._bindingDesc)
+		.setVertexAttributeDescriptions(_vertexInputInfo._attributeDesc);
+
+	_colorBlendState.setAttachments(_colorBlendAttachments);
+
+	_dynamicState.setDynamicStates(_dynamicStates);
+
+	_createInfo
+		.setStages(_shaderStages)
+		.setPVertexInputState(&_vertexInputState)
+		.setPInputAssemblyState(&_inputAssemblyState)
+		.setPViewportState(&_viewportState)
+		.setPDynamicState(&_dynamicState)
+		.setPRasterizationState(&_rasterizationState)
+		.setPColorBlendState(&_colorBlendState)
+		.setPMultisampleState(&_multisampleState)
+		.setPDepthStencilState(&_depthStencilState)
+		.setRenderPass(_renderPass)
+		.setSubpass(0);
+}
+
+void de::vulkan::async_create_pipeline::doJob()
+{
+	try
+	{
+		_pipeline = _device.createGraphicsPipeline(_cache, _createInfo).value;
+	}
+	catch (const vk::SystemError& error)
+	{
+		DE_LOG(Error, "%s: failed to create pipeline: %s", __FUNCTION__, error.what());
+	}
+
+	// pipeline does not reference render pass after creation
+	_device.destroyRenderPass(_renderPass);
+	_renderPass = nullptr;
+}
+
+vk::Pipeline de::vulkan::async_create_pipeline::extract()
+{
+	return std::exchange(_pipeline, nullptr);
+}
+
+void de::vulkan::async_create_pipeline::destroy()
+{
+	if (_renderPass)
+	{
+		_device.destroyRenderPass(_renderPass);
+		_renderPass = nullptr;
+	}
+	if (_pipeline)
+	{
+		_device.destroyPipeline(_pipeline);
+		_pipeline = nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "threads/thread_pool.hxx"
+
+#include "shader.hxx"
+
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace de::vulkan
+{
+	// graphics pipeline created on worker thread. owns every state create info points to,
+	// render pass included, so nothing it uses destroyed while driver compiles
+	struct async_create_pipeline : public de::async::thread_task
+	{
+		async_create_pipeline(vk::Device device, vk::PipelineCache cache)
+			: _device{device}
+			, _cache{cache}
+		{
+		}
+
+		virtual ~async_create_pipeline() override { destroy(); }
+
+		// point create info to states, call once every state set
+		void link();
+
+		virtual void doJob() override;
+
+		// null if creation failed or pipeline already extracted
+		vk::Pipeline extract();
+
+		// destroy what task still owns, task must not be executing
+		void destroy();
+
+		vk::Device _device;
+		vk::PipelineCache _cache;
+
+		shader::shared _vert;
+		shader::shared _frag;
+		std::array<vk::PipelineShaderStageCreateInfo, 2> _shaderStages;
+
+		shader::vertex_input_info _vertexInputInfo;
+		vk::PipelineVertexInputStateCreateInfo _vertexInputState;
+
+		std::array<vk::PipelineColorBlendAttachmentState, 1> _colorBlendAttachments;
+		vk::PipelineColorBlendStateCreateInfo _colorBlendState;
+
+		vk::PipelineInputAssemblyStateCreateInfo _inputAssemblyState;
+		vk::PipelineRasterizationStateCreateInfo _rasterizationState;
+		vk::PipelineMultisampleStateCreateInfo _multisampleState;
+		vk::PipelineDepthStencilStateCreateInfo _depthStencilState;
+		vk::PipelineViewportStateCreateInfo _viewportState;
+
+		std::vector<vk::DynamicState> _dynamicStates;
+		vk::PipelineDynamicStateCreateInfo _dynamicState;
+
+		vk::RenderPass _renderPass;
+
+		vk::GraphicsPipelineCreateInfo _createInfo;
+
+	private:
+		vk::Pipeline _pipeline;
+	};
+} // namespace de::vulkan
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "bindless_heap.hxx"
+
+#include "dreco.hxx"
+#include "renderer.hxx"
+
+#include <algorithm>
+
+void de::vulkan::bindless_heap::init()
+{
+	auto renderer = renderer::get();
+	auto device = renderer->getDevice();
+
+	const auto properties = renderer->getPhysicalDevice().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>();
+	const auto& indexingProperties = properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+	_capacity = std::min({maxTextures, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		indexingProperties.maxDescriptorSetUpdateAfterBindSamplers, indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+	// slots of freed images keep stale descriptors, never accessed by shaders
+	const auto binding = vk::DescriptorSetLayoutBinding()
+							 .setBinding(0)
+							 .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+							 .setDescriptorCount(_capacity)
+							 .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+	const vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound |
+													vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+													vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+	const auto bindingFlagsInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfo()
+									  .setBindingFlags(bindingFlags);
+
+	_layout = device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo()
+												   .setPNext(&bindingFlagsInfo)
+												   .setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+												   .setBindings(binding));
+
+	const auto poolSize = vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, _capacity);
+	_pool = device.createDescriptorPool(vk::DescriptorPoolCreateInfo()
+											.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind)
+											.setPoolSizes(poolSize)
+											.setMaxSets(1));
+
+	_set = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
+											 .setDescriptorPool(_pool)
+											 .setSetLayouts(_layout))
+			   .front();
+
+	DE_LOG(Info, "%s: bindless texture slots: %u", __FUNCTION__, _capacity);
+}
+
+void de::vulkan::bindless_heap::destroy()
+{
+	if (!_layout)
+	{
+		return;
+	}
+
+	auto device = renderer::get()->getDevice();
+	device.destroyDescriptorPool(_pool);
+	device.destroyDescriptorSetLayout(_layout);
+
+	new (this) bindless_heap();
+}
+
+uint32_t de::vulkan::bindless_heap::add(const image& img)
+{
+	uint32_t index = invalidIndex;
+	if (!_freeIndices.empty())
+	{
+		index = _freeIndices.back();
+		_freeIndices.pop_back();
+	}
+	else if (_nextIndex < _capacity)
+	{
+		index = _nextIndex++;
+	}
+	else
+	{
+		DE_LOG(Error, "%s: out of bindless texture slots, capacity %u", __FUNCTION__, _capacity);
+		return invalidIndex;
+	}
+
+	const auto imageInfo = vk::DescriptorImageInfo()
+							   .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+							   .setImageView(img.getImageView())
+							   .setSampler(img.getSampler());
+	const auto write = vk::WriteDescriptorSet()
+						   .setDstSet(_set)
+						   .setDstBinding(0)
+						   .setDstArrayElement(index)
+						   .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+						   .setImageInfo(imageInfo);
+	renderer::get()->getDevice().updateDescriptorSets(write, {});
+	return index;
+}
+
+void de::vulkan::bindless_heap::remove(uint32_t index)
+{
+	if (index == invalidIndex)
+	{
+		return;
+	}
+
+	renderer::get()->deferDestroy([this, index]()
+		{ _freeIndices.push_back(index); });
+}
\ No newline at end of file
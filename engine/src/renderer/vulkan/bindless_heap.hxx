@@ -0,0 +1,47 @@
+#pragma once
+#include "image.hxx"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace de::vulkan
+{
+	// global descriptor set with array of every texture, materials refer to textures by index to it.
+	// slots written once and never while in use, so set bound without any per material updates
+	class bindless_heap final
+	{
+	public:
+		static constexpr uint32_t maxTextures = 4096;
+		static constexpr uint32_t invalidIndex = std::numeric_limits<uint32_t>::max();
+
+		bindless_heap() = default;
+		bindless_heap(const bindless_heap&) = delete;
+		bindless_heap(bindless_heap&&) = delete;
+		~bindless_heap() { destroy(); }
+
+		void init();
+
+		void destroy();
+
+		// writes image view and sampler to free slot, image must be in shader read only layout once sampled
+		uint32_t add(const image& img);
+
+		// slot reused once frames that could sample it done
+		void remove(uint32_t index);
+
+		vk::DescriptorSetLayout getLayout() const { return _layout; }
+
+		vk::DescriptorSet getSet() const { return _set; }
+
+	private:
+		vk::DescriptorSetLayout _layout;
+		vk::DescriptorPool _pool;
+		vk::DescriptorSet _set;
+
+		uint32_t _capacity{};
+		uint32_t _nextIndex{};
+		std::vector<uint32_t> _freeIndices;
+	};
+} // namespace de::vulkan
\ No newline at end of file
@@ -5,7 +5,9 @@
 
 #include "core/misc/exceptions.hxx"
 
+#include <algorithm>
 #include <limits>
+#include <numeric>
 
 void de::vulkan::buffer::create(vk::MemoryPropertyFlags memoryPropertyFlags, vk::BufferUsageFlags usage, vk::DeviceSize size)
 {
@@ -13,15 +15,13 @@ void de::vulkan::buffer::create(vk::MemoryPropertyFlags memoryPropertyFlags, vk:
 
 	const renderer* renderer = renderer::get();
 	const auto device{renderer->getDevice()};
-	const auto sharingMode{renderer->getSharingMode()};
-	const auto queueIndexes{renderer->getQueueFamilyIndices()};
 
+	// exclusive, queues exchange ownership of written ranges with barriers
 	const vk::BufferCreateInfo bufferCreateInfo =
 		vk::BufferCreateInfo()
 			.setSize(size)
 			.setUsage(usage)
-			.setSharingMode(sharingMode)
-			.setQueueFamilyIndices(queueIndexes);
+			.setSharingMode(vk::SharingMode::eExclusive);
 
 	_buffer = device.createBuffer(bufferCreateInfo);
 }
@@ -59,136 +59,94 @@ vk::DeviceSize de::vulkan::buffer::getEnd() const
 	return getSize() + getOffset();
 }
 
-void de::vulkan::buffer::copyBuffer(const vk::Buffer bufferSrc, const vk::Buffer bufferDst, const std::vector<vk::BufferCopy>& bufferCopyRegions)
-{
-	renderer* renderer{renderer::get()};
-
-	vk::CommandBuffer commandBuffer = renderer->beginSingleTimeTransferCommands();
-
-	commandBuffer.copyBuffer(bufferSrc, bufferDst, bufferCopyRegions);
-	commandBuffer.end();
-
-	renderer->submitSingleTimeTransferCommands(commandBuffer);
-	renderer->getDevice().freeCommandBuffers(renderer->getTransferCommandPool(), commandBuffer);
-}
-
-vk::CommandBuffer de::vulkan::buffer::copyBufferToImage(const buffer& buffer, const vk::Image image, const vk::ImageLayout imageLayout, const uint32_t width, const uint32_t height, const uint32_t layerCount)
-{
-	renderer* renderer{renderer::get()};
-
-	vk::CommandBuffer commandBuffer = renderer->beginSingleTimeTransferCommands();
-
-	const vk::ImageSubresourceLayers imageSubresourceLayers =
-		vk::ImageSubresourceLayers()
-			.setAspectMask(vk::ImageAspectFlagBits::eColor)
-			.setMipLevel(0)
-			.setBaseArrayLayer(0)
-			.setLayerCount(layerCount);
-
-	const vk::BufferImageCopy copyRegion =
-		vk::BufferImageCopy()
-			.setBufferOffset(0)
-			.setBufferRowLength(0)
-			.setBufferImageHeight(0)
-			.setImageSubresource(imageSubresourceLayers)
-			.setImageOffset(vk::Offset3D(0, 0, 0))
-			.setImageExtent(vk::Extent3D(width, height, 1));
-
-	commandBuffer.copyBufferToImage(buffer.get(), image, imageLayout, copyRegion);
-	commandBuffer.end();
-
-	return commandBuffer;
-}
-
 void de::vulkan::buffer_pool::allocate(vk::MemoryPropertyFlags memoryPropertyFlags, vk::BufferUsageFlags usage, vk::DeviceSize size)
 {
 	_size = size;
 	_usage = usage;
 	_memoryPropertyFlags = memoryPropertyFlags;
 
-	buffer tempBuffer;
-	tempBuffer.create(_memoryPropertyFlags, _usage, _size);
+	const auto renderer{renderer::get()};
+	const auto device{renderer->getDevice()};
+
+	_buffer.create(_memoryPropertyFlags, _usage, _size);
 
-	const auto memoryRequirements = renderer::get()->getDevice().getBufferMemoryRequirements(tempBuffer.get());
+	const auto memoryRequirements = device.getBufferMemoryRequirements(_buffer.get());
 	_deviceMemory.allocate(memoryRequirements, _memoryPropertyFlags);
+	_buffer.bind(_deviceMemory, 0);
+
+	// views must satisfy descriptor offset limits, 16 also covers buffer to image copy of any format
+	const auto& limits = renderer->getPhysicalDevice().getProperties().limits;
+	_alignment = 16;
+	if (_usage & vk::BufferUsageFlagBits::eUniformBuffer)
+		_alignment = std::max(_alignment, limits.minUniformBufferOffsetAlignment);
+	if (_usage & vk::BufferUsageFlagBits::eStorageBuffer)
+		_alignment = std::max(_alignment, limits.minStorageBufferOffsetAlignment);
+
+	_allocator.init(_size);
 }
 
 void de::vulkan::buffer_pool::destroy()
 {
 	_buffers.clear();
+	_allocator.init(0);
+	_buffer.destroy();
 	_deviceMemory.free();
 }
 
-de::vulkan::buffer::id de::vulkan::buffer_pool::makeBuffer(vk::DeviceSize size)
+de::vulkan::buffer::id de::vulkan::buffer_pool::makeBuffer(vk::DeviceSize size, vk::DeviceSize alignment)
 {
-	// emplacing ruins everything
-	auto buffer = std::make_unique<de::vulkan::buffer>();
-	buffer->create(_memoryPropertyFlags, _usage, size);
-
-	const auto memoryRequirements = renderer::get()->getDevice().getBufferMemoryRequirements(buffer->get());
-	const auto offset = findBufferSpace(size, memoryRequirements.alignment);
-
-	if (std::numeric_limits<vk::DeviceSize>::max() == offset)
+	const auto allocation = _allocator.allocate(size, std::lcm(_alignment, std::max<vk::DeviceSize>(alignment, 1)));
+	if (!allocation.isValid())
 	{
 		throw de::except::out_of_space();
 		return std::numeric_limits<buffer::id>::max();
 	}
 
-	buffer->bind(_deviceMemory, offset);
+	buffer_view view;
+	view._buffer = _buffer.get();
+	view._allocation = allocation;
 
-	auto id = _buffers.emplace(_totalBuffersCounter++, std::move(buffer)).first->first;
+	auto id = _buffers.emplace(_totalBuffersCounter++, view).first->first;
 	return id;
 }
 
 void* de::vulkan::buffer_pool::map(buffer::id id)
 {
-	const auto& buffer = _buffers.at(id);
+	const auto& view = _buffers.at(id);
+	assert(_deviceMemory.getMapped());
 
-	const vk::Device device{renderer::get()->getDevice()};
-	return device.mapMemory(_deviceMemory.get(), buffer->getOffset(), buffer->getSize());
+	// buffer bound at zero memory offset, so view offset is memory offset
+	return reinterpret_cast<uint8_t*>(_deviceMemory.getMapped()) + view.getOffset();
 }
 
-void de::vulkan::buffer_pool::unmap(buffer::id id)
-{
-	const vk::Device device{renderer::get()->getDevice()};
-	device.unmapMemory(_deviceMemory.get());
-}
-
-void de::vulkan::buffer_pool::freeBuffer(buffer::id id)
+void de::vulkan::buffer_pool::flush(buffer::id id, vk::DeviceSize offset, vk::DeviceSize size)
 {
-	_buffers.erase(id);
+	const auto& view = _buffers.at(id);
+	_deviceMemory.flush(view.getOffset() + offset, size == VK_WHOLE_SIZE ? view.getSize() - offset : size);
 }
 
-const de::vulkan::buffer& de::vulkan::buffer_pool::getBuffer(buffer::id id) const
+void de::vulkan::buffer_pool::invalidate(buffer::id id)
 {
-	return *_buffers.at(id);
+	const auto& view = _buffers.at(id);
+	_deviceMemory.invalidate(view.getOffset(), view.getSize());
 }
 
-vk::DeviceSize de::vulkan::buffer_pool::findBufferSpace(vk::DeviceSize size, vk::DeviceSize allignment)
+void de::vulkan::buffer_pool::freeBuffer(buffer::id id)
 {
-	vk::DeviceSize offset = 0;
-
-	for (const auto& pair : _buffers)
+	const auto it = _buffers.find(id);
+	if (it != _buffers.end())
 	{
-		const auto& [buffer_id, buffer] = pair;
-
-		if (offset && buffer->getEnd() != offset)
-		{
-			if (buffer->getOffset() - offset >= size + allignment)
-			{
-				break;
-			}
-		}
-		offset = buffer->getEnd();
-
-		auto allignBy = offset % allignment;
-		offset = allignBy ? offset + allignment - allignBy : offset;
+		_allocator.free(it->second._allocation);
+		_buffers.erase(it);
 	}
+}
 
-	if ((offset == 0 && _buffers.size() != 0) || size > _size)
-	{
-		return std::numeric_limits<vk::DeviceSize>::max();
-	}
+const de::vulkan::buffer_view& de::vulkan::buffer_pool::getBuffer(buffer::id id) const
+{
+	return _buffers.at(id);
+}
 
-	return offset;
+de::allocators::tlsf_allocator::stats de::vulkan::buffer_pool::getStats() const
+{
+	return _allocator.getStats();
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include "allocators/tlsf_allocator.hxx"
+
 #include "device_memory.hxx"
 
 #include <map>
@@ -27,16 +29,28 @@ namespace de::vulkan
 		vk::DeviceSize getOffset() const;
 		vk::DeviceSize getEnd() const;
 
-		static void copyBuffer(const vk::Buffer bufferSrc, const vk::Buffer bufferDst, const std::vector<vk::BufferCopy>& bufferCopyRegions);
-
-		[[nodiscard]] static vk::CommandBuffer copyBufferToImage(const buffer& buffer, const vk::Image image, const vk::ImageLayout imageLayout, const uint32_t width, const uint32_t height, const uint32_t layerCount = 1);
-
 	private:
 		vk::Buffer _buffer{};
 		vk::DeviceSize _size{};
 		vk::DeviceSize _offset{};
 	};
 
+	// region of the buffer_pool buffer, offsets relative to vk buffer returned by get()
+	class buffer_view final
+	{
+		friend class buffer_pool;
+
+	public:
+		vk::Buffer get() const { return _buffer; }
+		vk::DeviceSize getSize() const { return _allocation._size; }
+		vk::DeviceSize getOffset() const { return _allocation._offset; }
+		vk::DeviceSize getEnd() const { return getOffset() + getSize(); }
+
+	private:
+		vk::Buffer _buffer{};
+		de::allocators::tlsf_allocator::allocation _allocation{};
+	};
+
 	class buffer_pool final
 	{
 	public:
@@ -48,25 +62,38 @@ namespace de::vulkan
 		void allocate(vk::MemoryPropertyFlags memoryPropertyFlags, vk::BufferUsageFlags usage, vk::DeviceSize size);
 		void destroy();
 
-		[[nodiscard]] buffer::id makeBuffer(vk::DeviceSize size);
+		// alignment applied on top of pool alignment, so offset of view could be multiple of element size
+		[[nodiscard]] buffer::id makeBuffer(vk::DeviceSize size, vk::DeviceSize alignment = 1);
 
+		// pointer into persistently mapped pool memory, host visible pools only
 		[[nodiscard]] void* map(buffer::id id);
-		void unmap(buffer::id id);
+
+		// range relative to buffer view, whole view by default
+		void flush(buffer::id id, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+		void invalidate(buffer::id id);
 
 		void freeBuffer(buffer::id id);
 
-		const buffer& getBuffer(const buffer::id id) const;
+		const buffer_view& getBuffer(const buffer::id id) const;
 
-	private:
-		vk::DeviceSize findBufferSpace(vk::DeviceSize size, vk::DeviceSize allignment);
+		// whole pool buffer, views are ranges of it
+		vk::Buffer get() const { return _buffer.get(); }
+
+		de::allocators::tlsf_allocator::stats getStats() const;
 
+	private:
 		device_memory _deviceMemory;
 
+		// single vk buffer bound to whole memory, sub-allocated by _allocator
+		buffer _buffer;
+		de::allocators::tlsf_allocator _allocator;
+		vk::DeviceSize _alignment{1};
+
 		vk::DeviceSize _size;
 		vk::BufferUsageFlags _usage;
 		vk::MemoryPropertyFlags _memoryPropertyFlags;
 
-		std::map<buffer::id, buffer::unique> _buffers;
-		buffer::id _totalBuffersCounter;
+		std::map<buffer::id, buffer_view> _buffers;
+		buffer::id _totalBuffersCounter{};
 	};
 } // namespace de::vulkan
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace de::vulkan::constants
 {
 	namespace shaders
@@ -9,11 +11,46 @@ namespace de::vulkan::constants
 
 		inline const char* const skyboxVert = "skybox.vert.spv";
 		inline const char* const skyboxFrag = "skybox.frag.spv";
+
+		inline const char* const cullComp = "cull.comp.spv";
+		inline const char* const cullCompactComp = "cull_compact.comp.spv";
+		inline const char* const hizDepthComp = "hiz_depth.comp.spv";
+		inline const char* const hizDepthMsComp = "hiz_depth_ms.comp.spv";
+		inline const char* const hizReduceComp = "hiz_reduce.comp.spv";
 	} // namespace shaders
 
+	namespace descriptors
+	{
+		// sets shared by every material, owned by renderer and bound once per command buffer.
+		// every material layout starts with them, so pipeline switches keep them bound
+		inline constexpr uint32_t frameSet = 0;
+		inline constexpr uint32_t bindlessSet = 1;
+		inline constexpr uint32_t globalSetCount = 2;
+
+		// uniform buffers with that names bound as dynamic, offset selects slice of current view frame
+		inline const char* const cameraData = "cameraData";
+		inline const char* const cullData = "cullData";
+
+		// sampler array with that name is set of bindless heap, expected in bindlessSet
+		inline const char* const textures = "textures";
+	} // namespace descriptors
+
 	namespace materials
 	{
 		inline const char* const basic = "basic";
 		inline const char* const skybox = "skybox";
 	} // namespace materials
+
+	namespace pipelines
+	{
+		// pipeline cache data saved at exit and loaded on next launch, relative to shaders binary dir
+		inline const char* const cacheFile = "pipeline_cache.bin";
+	} // namespace pipelines
+
+	namespace frames
+	{
+		// cpu records frame while gpu still executes up to that much previous frames
+		inline constexpr uint32_t minInFlight = 2;
+		inline constexpr uint32_t maxInFlight = 3;
+	} // namespace frames
 } // namespace de::vulkan::constants
\ No newline at end of file
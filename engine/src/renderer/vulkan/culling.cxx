@@ -0,0 +1,451 @@
+#include "culling.hxx"
+
+#include "math/frustum.hxx"
+#include "renderer/shader_types/cull_data.hxx"
+
+#include "constants.hxx"
+#include "dreco.hxx"
+#include "renderer.hxx"
+#include "view.hxx"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr uint32_t cullGroupSize = 64;
+	constexpr uint32_t hizGroupSize = 8;
+
+	// more than enough for pyramid of any view extent
+	constexpr uint32_t maxHiZMips = 16;
+
+	constexpr uint32_t scenesPerDescriptorPool = 64;
+
+	struct cull_push_constants
+	{
+		uint32_t _objectCount;
+		uint32_t _objectsOffset;
+		uint32_t _commandsOffset;
+	};
+
+	struct compact_push_constants
+	{
+		uint32_t _commandCount;
+		uint32_t _objectsOffset;
+		uint32_t _commandsOffset;
+		uint32_t _drawCountsOffset;
+		uint32_t _compact;
+	};
+
+	// samples pushed only to multisampled depth pipeline, size of push range tells
+	struct hiz_push_constants
+	{
+		int32_t _srcWidth, _srcHeight;
+		int32_t _dstWidth, _dstHeight;
+		int32_t _samples;
+	};
+
+	uint32_t groupCount(uint32_t count, uint32_t groupSize)
+	{
+		return (count + groupSize - 1) / groupSize;
+	}
+} // namespace
+
+void de::vulkan::culling::compute_pipeline::create(vk::Device device, shader::shared computeShader)
+{
+	_shader = computeShader;
+
+	auto dataSets = _shader->getDescirptorShaderData();
+	std::sort(dataSets.begin(), dataSets.end(), [](const auto& a, const auto& b)
+		{ return a._descriptorSetIndex < b._descriptorSetIndex; });
+	for (const auto& data : dataSets)
+	{
+		_setLayouts.push_back(device.createDescriptorSetLayout(data._descriptorSetLayoutCreateInfo));
+	}
+
+	const auto ranges = _shader->getPushConstantRanges();
+	for (const auto& range : ranges)
+	{
+		_pushConstantsSize = std::max(_pushConstantsSize, range.offset + range.size);
+	}
+
+	_layout = device.createPipelineLayout(vk::PipelineLayoutCreateInfo()
+											  .setSetLayouts(_setLayouts)
+											  .setPushConstantRanges(ranges));
+
+	const auto pipelineCreateInfo = vk::ComputePipelineCreateInfo()
+										.setStage(_shader->getPipelineShaderStageCreateInfo())
+										.setLayout(_layout);
+
+	auto createPipelineResult = device.createComputePipeline(renderer::get()->getPipelineCache(), pipelineCreateInfo);
+	assert(vk::Result::eSuccess == createPipelineResult.result);
+	_pipeline = createPipelineResult.value;
+}
+
+void de::vulkan::culling::compute_pipeline::destroy(vk::Device device)
+{
+	if (_pipeline)
+	{
+		device.destroyPipeline(_pipeline);
+		_pipeline = nullptr;
+	}
+	if (_layout)
+	{
+		device.destroyPipelineLayout(_layout);
+		_layout = nullptr;
+	}
+	for (auto layout : _setLayouts)
+	{
+		device.destroyDescriptorSetLayout(layout);
+	}
+	_setLayouts.clear();
+	_shader.reset();
+}
+
+void de::vulkan::culling::init()
+{
+	auto renderer = renderer::get();
+	auto device = renderer->getDevice();
+
+	_cull.create(device, renderer->loadShader(DRECO_SHADER(constants::shaders::cullComp)));
+	_compact.create(device, renderer->loadShader(DRECO_SHADER(constants::shaders::cullCompactComp)));
+	_hizDepth.create(device, renderer->loadShader(DRECO_SHADER(constants::shaders::hizDepthComp)));
+	_hizDepthMs.create(device, renderer->loadShader(DRECO_SHADER(constants::shaders::hizDepthMsComp)));
+	_hizReduce.create(device, renderer->loadShader(DRECO_SHADER(constants::shaders::hizReduceComp)));
+
+	createViewDescriptorPool();
+
+	_cullDataBufferId = renderer->getFrameUniformBufferPool().makeBuffer(renderer->getFrameSliceStride(sizeof(cull_data)) * renderer->getFrameSliceCount());
+}
+
+void de::vulkan::culling::destroy()
+{
+	auto renderer = renderer::get();
+	if (renderer == nullptr || !_cull._pipeline)
+	{
+		return;
+	}
+	auto device = renderer->getDevice();
+
+	// sets freed together with pools
+	_views = {};
+
+	device.destroyDescriptorPool(_viewDescriptorPool);
+	_viewDescriptorPool = nullptr;
+	for (auto pool : _sceneDescriptorPools)
+	{
+		device.destroyDescriptorPool(pool);
+	}
+	_sceneDescriptorPools.clear();
+
+	_cull.destroy(device);
+	_compact.destroy(device);
+	_hizDepth.destroy(device);
+	_hizDepthMs.destroy(device);
+	_hizReduce.destroy(device);
+
+	renderer->getFrameUniformBufferPool().freeBuffer(_cullDataBufferId);
+	_cullDataBufferId = std::numeric_limits<buffer::id>::max();
+}
+
+de::vulkan::culling::scene_dispatch de::vulkan::culling::makeSceneDispatch(const scene_bindings& bindings, uint32_t objectCount, uint32_t commandCount, uint32_t materialCount)
+{
+	auto device = renderer::get()->getDevice();
+
+	scene_dispatch out;
+	out._objectCount = objectCount;
+	out._commandCount = commandCount;
+	out._materialCount = materialCount;
+	out._instanceCounts = bindings._instanceCounts;
+	out._drawCounts = bindings._drawCounts;
+
+	const std::array<vk::DescriptorSetLayout, 2> setLayouts{_cull._setLayouts[0], _compact._setLayouts[0]};
+	std::vector<vk::DescriptorSet> sets;
+	try
+	{
+		if (_sceneDescriptorPools.empty())
+		{
+			_sceneDescriptorPools.push_back(createSceneDescriptorPool());
+		}
+		sets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
+												 .setDescriptorPool(_sceneDescriptorPools.back())
+												 .setSetLayouts(setLayouts));
+	}
+	catch (vk::OutOfPoolMemoryError)
+	{
+		DE_LOG(Info, "%s: Scene descriptor pool full, adding another one", __FUNCTION__);
+
+		_sceneDescriptorPools.push_back(createSceneDescriptorPool());
+		sets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
+												 .setDescriptorPool(_sceneDescriptorPools.back())
+												 .setSetLayouts(setLayouts));
+	}
+	out._pool = _sceneDescriptorPools.back();
+	out._cullSet = sets[0];
+	out._compactSet = sets[1];
+
+	const auto bufferInfo = [](const buffer_view* buffer)
+	{
+		return vk::DescriptorBufferInfo(buffer->get(), buffer->getOffset(), buffer->getSize());
+	};
+	const std::array<vk::DescriptorBufferInfo, 4> cullInfos{bufferInfo(bindings._objects), bufferInfo(bindings._commands), bufferInfo(bindings._instanceCounts), bufferInfo(bindings._visibleObjects)};
+	const std::array<vk::DescriptorBufferInfo, 4> compactInfos{bufferInfo(bindings._commands), bufferInfo(bindings._instanceCounts), bufferInfo(bindings._drawCommands), bufferInfo(bindings._drawCounts)};
+
+	std::vector<vk::WriteDescriptorSet> writes;
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		writes.emplace_back(out._cullSet, i, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &cullInfos[i]);
+		writes.emplace_back(out._compactSet, i, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &compactInfos[i]);
+	}
+	device.updateDescriptorSets(writes, {});
+
+	return out;
+}
+
+void de::vulkan::culling::freeSceneDispatch(scene_dispatch& dispatch)
+{
+	if (!dispatch._pool)
+	{
+		return;
+	}
+
+	auto renderer = renderer::get();
+	renderer->deferDestroy([device = renderer->getDevice(), pool = dispatch._pool, sets = std::array{dispatch._cullSet, dispatch._compactSet}]()
+		{ device.freeDescriptorSets(pool, sets); });
+	dispatch = scene_dispatch();
+}
+
+void de::vulkan::culling::cullCmd(vk::CommandBuffer commandBuffer, const view& currentView, const de::math::mat4& viewProj)
+{
+	auto renderer = renderer::get();
+
+	auto& state = _views[renderer->getCurrentDrawViewIndex()];
+	updateViewState(currentView, state);
+
+	const uint32_t sliceIndex = renderer->getFrameSliceIndex();
+	{
+		// slice of current view frame, previous reader of it is frame which fence already waited
+		cull_data cullData;
+		cullData._frustumPlanes = de::math::frustum::makeFromViewProjection(viewProj)._planes;
+		cullData._prevViewProj = state._prevViewProj;
+		cullData._hizSize = de::math::vec2(static_cast<float>(state._hiz->getExtent().width), static_cast<float>(state._hiz->getExtent().height));
+		cullData._hizMipCount = static_cast<uint32_t>(state._hizSets.size());
+		cullData._occlusion = state._hizValid;
+
+		auto& bpFrameUniforms = renderer->getFrameUniformBufferPool();
+		const vk::DeviceSize sliceOffset = sliceIndex * renderer->getFrameSliceStride(sizeof(cull_data));
+		auto* mapped = reinterpret_cast<uint8_t*>(bpFrameUniforms.map(_cullDataBufferId));
+		memcpy(mapped + sliceOffset, &cullData, sizeof(cullData));
+		bpFrameUniforms.flush(_cullDataBufferId, sliceOffset, sizeof(cullData));
+	}
+	state._prevViewProj = viewProj;
+
+	std::vector<const scene_dispatch*> dispatches;
+	for (const auto& scene : renderer->getScenes())
+	{
+		if (const auto dispatch = scene->getCullDispatch())
+		{
+			dispatches.push_back(dispatch);
+		}
+	}
+	if (dispatches.empty())
+	{
+		return;
+	}
+
+	for (const auto dispatch : dispatches)
+	{
+		const vk::DeviceSize instanceCountsSize = dispatch->_commandCount * sizeof(uint32_t);
+		commandBuffer.fillBuffer(dispatch->_instanceCounts->get(), dispatch->_instanceCounts->getOffset() + sliceIndex * instanceCountsSize, instanceCountsSize, 0);
+
+		const vk::DeviceSize drawCountsSize = dispatch->_materialCount * sizeof(uint32_t);
+		commandBuffer.fillBuffer(dispatch->_drawCounts->get(), dispatch->_drawCounts->getOffset() + sliceIndex * drawCountsSize, drawCountsSize, 0);
+	}
+
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {},
+		vk::MemoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite), {}, {});
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, _cull._pipeline);
+
+	const uint32_t cullDataOffset = static_cast<uint32_t>(sliceIndex * renderer->getFrameSliceStride(sizeof(cull_data)));
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _cull._layout, 1, state._cullSet, cullDataOffset);
+	for (const auto dispatch : dispatches)
+	{
+		const cull_push_constants pushConstants{
+			._objectCount = dispatch->_objectCount,
+			._objectsOffset = sliceIndex * dispatch->_objectCount,
+			._commandsOffset = sliceIndex * dispatch->_commandCount};
+
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _cull._layout, 0, dispatch->_cullSet, {});
+		commandBuffer.pushConstants(_cull._layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pushConstants), &pushConstants);
+		commandBuffer.dispatch(groupCount(dispatch->_objectCount, cullGroupSize), 1, 1);
+	}
+
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {},
+		vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite), {}, {});
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, _compact._pipeline);
+	for (const auto dispatch : dispatches)
+	{
+		const compact_push_constants pushConstants{
+			._commandCount = dispatch->_commandCount,
+			._objectsOffset = sliceIndex * dispatch->_objectCount,
+			._commandsOffset = sliceIndex * dispatch->_commandCount,
+			._drawCountsOffset = sliceIndex * dispatch->_materialCount,
+			._compact = renderer->isDrawIndirectCountSupported()};
+
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _compact._layout, 0, dispatch->_compactSet, {});
+		commandBuffer.pushConstants(_compact._layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pushConstants), &pushConstants);
+		commandBuffer.dispatch(groupCount(dispatch->_commandCount, cullGroupSize), 1, 1);
+	}
+
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader, {},
+		vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead), {}, {});
+}
+
+void de::vulkan::culling::buildHiZCmd(vk::CommandBuffer commandBuffer, const view& currentView)
+{
+	auto renderer = renderer::get();
+
+	auto& state = _views[renderer->getCurrentDrawViewIndex()];
+	if (state._hiz == nullptr)
+	{
+		return;
+	}
+
+	// depth write made visible by render pass dependency, pyramid reads of culling must finish before it rewritten
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, {});
+
+	const bool isMultisampled = state._depthSamples != vk::SampleCountFlagBits::e1;
+	const auto& depthPipeline = isMultisampled ? _hizDepthMs : _hizDepth;
+
+	for (uint32_t mip = 0; mip < state._hizSets.size(); ++mip)
+	{
+		const vk::Extent2D srcExtent = mip == 0 ? state._depthExtent : state._hiz->getMipExtent(mip - 1);
+		const vk::Extent2D dstExtent = state._hiz->getMipExtent(mip);
+		const auto& pipeline = mip == 0 ? depthPipeline : _hizReduce;
+
+		if (mip != 0)
+		{
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {},
+				vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead), {}, {});
+		}
+
+		const hiz_push_constants pushConstants{
+			._srcWidth = static_cast<int32_t>(srcExtent.width),
+			._srcHeight = static_cast<int32_t>(srcExtent.height),
+			._dstWidth = static_cast<int32_t>(dstExtent.width),
+			._dstHeight = static_cast<int32_t>(dstExtent.height),
+			._samples = static_cast<int32_t>(state._depthSamples)};
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline._pipeline);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline._layout, 0, state._hizSets[mip], {});
+		commandBuffer.pushConstants(pipeline._layout, vk::ShaderStageFlagBits::eCompute, 0, pipeline._pushConstantsSize, &pushConstants);
+		commandBuffer.dispatch(groupCount(dstExtent.width, hizGroupSize), groupCount(dstExtent.height, hizGroupSize), 1);
+	}
+
+	// next frame of the view samples pyramid in culling
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {},
+		vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead), {}, {});
+
+	state._hizValid = true;
+}
+
+void de::vulkan::culling::updateViewState(const view& currentView, view_state& state)
+{
+	const auto& depthImage = currentView.getDepthImage();
+	const auto depthExtent = currentView.getCurrentExtent();
+	const auto depthSamples = currentView.getSettings().getSampleCount();
+	if (state._hiz != nullptr && state._depthView == depthImage.getDepthView() && state._depthExtent == depthExtent && state._depthSamples == depthSamples)
+	{
+		return;
+	}
+
+	auto renderer = renderer::get();
+	auto device = renderer->getDevice();
+
+	// old pyramid could be used by frames in flight
+	if (state._hiz != nullptr)
+	{
+		std::vector<vk::DescriptorSet> sets = std::move(state._hizSets);
+		sets.push_back(state._cullSet);
+
+		std::shared_ptr<vk_hiz_image> oldHiZ = std::move(state._hiz);
+		renderer->deferDestroy([device, pool = _viewDescriptorPool, sets = std::move(sets), oldHiZ]()
+			{
+				device.freeDescriptorSets(pool, sets);
+				oldHiZ->destroy();
+			});
+	}
+
+	state = view_state();
+	state._depthView = depthImage.getDepthView();
+	state._depthExtent = depthExtent;
+	state._depthSamples = depthSamples;
+
+	state._hiz = std::make_unique<vk_hiz_image>();
+	state._hiz->create(renderer->getCurrentDrawViewIndex());
+
+	const uint32_t mipCount = std::min(state._hiz->getMipCount(), maxHiZMips);
+
+	std::vector<vk::DescriptorSetLayout> setLayouts{_cull._setLayouts[1]};
+	setLayouts.push_back(depthSamples != vk::SampleCountFlagBits::e1 ? _hizDepthMs._setLayouts[0] : _hizDepth._setLayouts[0]);
+	setLayouts.insert(setLayouts.end(), mipCount - 1, _hizReduce._setLayouts[0]);
+
+	auto sets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
+												  .setDescriptorPool(_viewDescriptorPool)
+												  .setSetLayouts(setLayouts));
+	state._cullSet = sets[0];
+	state._hizSets.assign(sets.begin() + 1, sets.end());
+
+	const auto& cullDataBuffer = renderer->getFrameUniformBufferPool().getBuffer(_cullDataBufferId);
+	const vk::DescriptorBufferInfo cullDataInfo(cullDataBuffer.get(), cullDataBuffer.getOffset(), sizeof(cull_data));
+	const vk::DescriptorImageInfo hizInfo(state._hiz->getSampler(), state._hiz->getImageView(), vk::ImageLayout::eGeneral);
+	const vk::DescriptorImageInfo depthInfo(state._hiz->getSampler(), state._depthView, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+
+	std::vector<vk::DescriptorImageInfo> mipInfos;
+	mipInfos.reserve(mipCount);
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		mipInfos.emplace_back(nullptr, state._hiz->getMipView(mip), vk::ImageLayout::eGeneral);
+	}
+
+	std::vector<vk::WriteDescriptorSet> writes;
+	writes.emplace_back(state._cullSet, 0, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &cullDataInfo);
+	writes.emplace_back(state._cullSet, 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &hizInfo);
+	writes.emplace_back(state._hizSets[0], 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &depthInfo);
+	writes.emplace_back(state._hizSets[0], 1, 0, 1, vk::DescriptorType::eStorageImage, &mipInfos[0]);
+	for (uint32_t mip = 1; mip < mipCount; ++mip)
+	{
+		writes.emplace_back(state._hizSets[mip], 0, 0, 1, vk::DescriptorType::eStorageImage, &mipInfos[mip - 1]);
+		writes.emplace_back(state._hizSets[mip], 1, 0, 1, vk::DescriptorType::eStorageImage, &mipInfos[mip]);
+	}
+	device.updateDescriptorSets(writes, {});
+}
+
+void de::vulkan::culling::createViewDescriptorPool()
+{
+	// twice of every view, old sets of view freed only once frames in flight done
+	constexpr uint32_t viewSlots = 2 * std::tuple_size_v<decltype(_views)>;
+
+	const std::array<vk::DescriptorPoolSize, 3> poolSizes{
+		vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, viewSlots),
+		vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, viewSlots * 2),
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, viewSlots * maxHiZMips * 2)};
+
+	_viewDescriptorPool = renderer::get()->getDevice().createDescriptorPool(vk::DescriptorPoolCreateInfo()
+																				.setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet)
+																				.setPoolSizes(poolSizes)
+																				.setMaxSets(viewSlots * (maxHiZMips + 1)));
+}
+
+vk::DescriptorPool de::vulkan::culling::createSceneDescriptorPool()
+{
+	// cull and compact set of every scene, both with four storage buffers
+	const std::array<vk::DescriptorPoolSize, 1> poolSizes{
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, scenesPerDescriptorPool * 8)};
+
+	return renderer::get()->getDevice().createDescriptorPool(vk::DescriptorPoolCreateInfo()
+																 .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet)
+																 .setPoolSizes(poolSizes)
+																 .setMaxSets(scenesPerDescriptorPool * 2));
+}
\ No newline at end of file
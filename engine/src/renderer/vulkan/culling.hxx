@@ -0,0 +1,121 @@
+#pragma once
+#include "images/hiz_image.hxx"
+#include "math/mat4.hxx"
+
+#include "buffer.hxx"
+#include "shader.hxx"
+
+#include <array>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace de::vulkan
+{
+	class view;
+
+	// compute pre-pass testing scene objects against view frustum and hi-z pyramid of previous frame depth of the view.
+	// scene buffers hold slice for every view frame, so same scene culled for every view without copies of its data
+	class culling final
+	{
+	public:
+		// scene buffers culling reads and writes, counters and outputs sized for every frame slice
+		struct scene_bindings
+		{
+			const buffer_view* _objects{};
+			const buffer_view* _commands{};
+			const buffer_view* _instanceCounts{};
+			const buffer_view* _visibleObjects{};
+			const buffer_view* _drawCommands{};
+			const buffer_view* _drawCounts{};
+		};
+
+		// everything needed to dispatch culling of the scene
+		struct scene_dispatch
+		{
+			vk::DescriptorPool _pool;
+			vk::DescriptorSet _cullSet;
+			vk::DescriptorSet _compactSet;
+
+			uint32_t _objectCount{};
+			uint32_t _commandCount{};
+			uint32_t _materialCount{};
+
+			const buffer_view* _instanceCounts{};
+			const buffer_view* _drawCounts{};
+		};
+
+		culling() = default;
+		culling(const culling&) = delete;
+		culling(culling&&) = delete;
+		~culling() { destroy(); };
+
+		void init();
+
+		void destroy();
+
+		scene_dispatch makeSceneDispatch(const scene_bindings& bindings, uint32_t objectCount, uint32_t commandCount, uint32_t materialCount);
+
+		// sets freed once frames in flight that may use them done
+		void freeSceneDispatch(scene_dispatch& dispatch);
+
+		// zero counters, cull objects of every scene and compact their draws to slice of current view frame.
+		// viewProj is view * proj of current frame, recorded before render pass
+		void cullCmd(vk::CommandBuffer commandBuffer, const view& currentView, const de::math::mat4& viewProj);
+
+		// reduce depth of finished render pass to pyramid next frame of the view tested against
+		void buildHiZCmd(vk::CommandBuffer commandBuffer, const view& currentView);
+
+	private:
+		struct compute_pipeline
+		{
+			shader::shared _shader;
+			std::vector<vk::DescriptorSetLayout> _setLayouts;
+			vk::PipelineLayout _layout;
+			vk::Pipeline _pipeline;
+			uint32_t _pushConstantsSize{};
+
+			void create(vk::Device device, shader::shared computeShader);
+			void destroy(vk::Device device);
+		};
+
+		// pyramid and descriptor sets of the view, recreated when depth image of the view changes
+		struct view_state
+		{
+			std::unique_ptr<vk_hiz_image> _hiz;
+			vk::ImageView _depthView;
+			vk::Extent2D _depthExtent;
+			vk::SampleCountFlagBits _depthSamples{vk::SampleCountFlagBits::e1};
+
+			vk::DescriptorSet _cullSet;
+
+			// depth to mip 0 first, then mip to next one
+			std::vector<vk::DescriptorSet> _hizSets;
+
+			de::math::mat4 _prevViewProj{de::math::mat4::makeIdentity()};
+
+			// pyramid has depth of previous frame
+			bool _hizValid{false};
+		};
+
+		void updateViewState(const view& currentView, view_state& state);
+
+		void createViewDescriptorPool();
+
+		vk::DescriptorPool createSceneDescriptorPool();
+
+		compute_pipeline _cull;
+		compute_pipeline _compact;
+		compute_pipeline _hizDepth;
+		compute_pipeline _hizDepthMs;
+		compute_pipeline _hizReduce;
+
+		vk::DescriptorPool _viewDescriptorPool;
+		std::vector<vk::DescriptorPool> _sceneDescriptorPools;
+
+		std::array<view_state, 16> _views;
+
+		buffer::id _cullDataBufferId{std::numeric_limits<buffer::id>::max()};
+	};
+} // namespace de::vulkan
\ No newline at end of file
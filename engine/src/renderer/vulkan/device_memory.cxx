@@ -16,6 +16,15 @@ void de::vulkan::device_memory::allocate(const vk::MemoryRequirements& memoryReq
 	{
 		const vk::MemoryAllocateInfo memoryAllocateInfo(memoryRequirements.size, memoryTypeIndex);
 		_deviceMemory = device.allocateMemory(memoryAllocateInfo);
+
+		_size = memoryRequirements.size;
+		_memoryPropertyFlags = physicalDevice.getMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags;
+		_nonCoherentAtomSize = physicalDevice.getProperties().limits.nonCoherentAtomSize;
+
+		if (_memoryPropertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+		{
+			_mapped = device.mapMemory(_deviceMemory, 0, VK_WHOLE_SIZE);
+		}
 	}
 }
 
@@ -24,6 +33,11 @@ void de::vulkan::device_memory::free()
 	if (_deviceMemory)
 	{
 		const vk::Device device = renderer::get()->getDevice();
+		if (_mapped)
+		{
+			device.unmapMemory(_deviceMemory);
+			_mapped = nullptr;
+		}
 		device.freeMemory(_deviceMemory);
 		_deviceMemory = nullptr;
 	}
@@ -31,10 +45,9 @@ void de::vulkan::device_memory::free()
 
 void de::vulkan::device_memory::map(const void* data, const vk::DeviceSize size, const vk::DeviceSize offset)
 {
-	const vk::Device device = renderer::get()->getDevice();
-	void* region = device.mapMemory(_deviceMemory, offset, size);
-	memcpy(region, data, size);
-	device.unmapMemory(_deviceMemory);
+	assert(_mapped);
+	memcpy(reinterpret_cast<uint8_t*>(_mapped) + offset, data, size);
+	flush(offset, size);
 }
 
 void de::vulkan::device_memory::map(const std::vector<map_memory_region>& regions, const vk::DeviceSize offset)
@@ -44,13 +57,43 @@ void de::vulkan::device_memory::map(const std::vector<map_memory_region>& region
 		return;
 	}
 
-	const vk::Device device = renderer::get()->getDevice();
-	void* region = device.mapMemory(_deviceMemory, offset, VK_WHOLE_SIZE);
+	assert(_mapped);
+	uint8_t* region = reinterpret_cast<uint8_t*>(_mapped) + offset;
 	for (const auto& reg : regions)
 	{
-		memcpy(reinterpret_cast<uint8_t*>(region) + reg.offset, reg.data, reg.size);
+		memcpy(region + reg.offset, reg.data, reg.size);
+	}
+	flush(offset);
+}
+
+void de::vulkan::device_memory::flush(const vk::DeviceSize offset, const vk::DeviceSize size)
+{
+	if (_mapped && !isHostCoherent())
+	{
+		renderer::get()->getDevice().flushMappedMemoryRanges(makeAtomAlignedRange(offset, size));
+	}
+}
+
+void de::vulkan::device_memory::invalidate(const vk::DeviceSize offset, const vk::DeviceSize size)
+{
+	if (_mapped && !isHostCoherent())
+	{
+		renderer::get()->getDevice().invalidateMappedMemoryRanges(makeAtomAlignedRange(offset, size));
+	}
+}
+
+vk::MappedMemoryRange de::vulkan::device_memory::makeAtomAlignedRange(const vk::DeviceSize offset, const vk::DeviceSize size) const
+{
+	// range must be multiple of nonCoherentAtomSize or reach end of the allocation
+	const vk::DeviceSize begin = offset - offset % _nonCoherentAtomSize;
+	vk::DeviceSize alignedSize = VK_WHOLE_SIZE;
+	if (size != VK_WHOLE_SIZE)
+	{
+		const vk::DeviceSize end = offset + size;
+		const vk::DeviceSize alignedEnd = end % _nonCoherentAtomSize ? end + _nonCoherentAtomSize - end % _nonCoherentAtomSize : end;
+		alignedSize = alignedEnd < _size ? alignedEnd - begin : VK_WHOLE_SIZE;
 	}
-	device.unmapMemory(_deviceMemory);
+	return vk::MappedMemoryRange(_deviceMemory, begin, alignedSize);
 }
 
 uint32_t de::vulkan::device_memory::findMemoryTypeIndex(const vk::PhysicalDeviceMemoryProperties& memoryProperties, uint32_t memoryTypeBits, vk::MemoryPropertyFlags memoryPropertyFlags)
@@ -26,13 +26,34 @@ namespace de::vulkan
 
 		void map(const std::vector<map_memory_region>& regions, const vk::DeviceSize offset = 0);
 
+		// make host writes visible to device, no-op for coherent memory
+		void flush(const vk::DeviceSize offset = 0, const vk::DeviceSize size = VK_WHOLE_SIZE);
+
+		// make device writes visible to host, no-op for coherent memory
+		void invalidate(const vk::DeviceSize offset = 0, const vk::DeviceSize size = VK_WHOLE_SIZE);
+
 		vk::DeviceMemory get() const { return _deviceMemory; };
 
+		// host visible memory mapped once on allocate and stays mapped until free
+		void* getMapped() const { return _mapped; };
+
+		bool isHostCoherent() const { return static_cast<bool>(_memoryPropertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent); };
+
 	protected:
 		static uint32_t findMemoryTypeIndex(const vk::PhysicalDeviceMemoryProperties& memoryProperties,
 			uint32_t memoryTypeBits, vk::MemoryPropertyFlags memoryPropertyFlags);
 
 	private:
+		vk::MappedMemoryRange makeAtomAlignedRange(const vk::DeviceSize offset, const vk::DeviceSize size) const;
+
 		vk::DeviceMemory _deviceMemory;
+
+		vk::DeviceSize _size{};
+
+		vk::MemoryPropertyFlags _memoryPropertyFlags{};
+
+		vk::DeviceSize _nonCoherentAtomSize{1};
+
+		void* _mapped{nullptr};
 	};
 } // namespace de::vulkan
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "draw_list.hxx"
+
+#include "constants.hxx"
+#include "material.hxx"
+#include "renderer.hxx"
+#include "scene.hxx"
+
+#include <algorithm>
+#include <bit>
+
+de::vulkan::draw_stats& de::vulkan::draw_stats::operator+=(const draw_stats& other)
+{
+	_draws += other._draws;
+	_requestedBinds += other._requestedBinds;
+	_pipelineBinds += other._pipelineBinds;
+	_descriptorSetBinds += other._descriptorSetBinds;
+	_geometryBinds += other._geometryBinds;
+	return *this;
+}
+
+uint64_t de::vulkan::draw_list::makeKey(uint32_t view, uint32_t pipeline, uint32_t descriptorSet, float depth)
+{
+	// bits of non-negative float ordered as its value
+	const uint32_t depthBits = std::bit_cast<uint32_t>(std::max(depth, 0.F));
+
+	return (static_cast<uint64_t>(view & 0xF) << 60) |
+		   (static_cast<uint64_t>(pipeline & 0xFFF) << 48) |
+		   (static_cast<uint64_t>(descriptorSet & 0xFFFF) << 32) |
+		   static_cast<uint64_t>(depthBits);
+}
+
+void de::vulkan::draw_list::build(uint32_t viewIndex, const std::vector<std::unique_ptr<scene>>& scenes, const de::math::frustum& frustum)
+{
+	_items.clear();
+	_materials.clear();
+
+	const auto& nearPlane = frustum._planes[4];
+	for (const auto& scn : scenes)
+	{
+		if (scn->getCullDispatch() == nullptr)
+			continue;
+
+		for (uint32_t i = 0; i < scn->getMaterialCount(); ++i)
+		{
+			if (!scn->isMaterialVisible(i))
+				continue;
+
+			// few materials per frame, so linear search keeps ids dense
+			const material* mat = scn->getMaterialInstance(i)->getMaterial();
+			auto matIt = std::find(_materials.begin(), _materials.end(), mat);
+			if (matIt == _materials.end())
+			{
+				matIt = _materials.insert(_materials.end(), mat);
+			}
+			const uint32_t pipeline = std::distance(_materials.begin(), matIt);
+
+			const auto center = scn->getMaterialBounds(i).getCenter();
+			const float depth = nearPlane._x * center._x + nearPlane._y * center._y + nearPlane._z * center._z + nearPlane._w;
+
+			_items.push_back(item{makeKey(viewIndex, pipeline, i, depth), scn.get(), i});
+		}
+	}
+
+	std::sort(_items.begin(), _items.end(), [](const item& a, const item& b)
+		{ return a._key < b._key; });
+}
+
+void de::vulkan::draw_list::record(vk::CommandBuffer commandBuffer, size_t first, size_t count, draw_stats& stats) const
+{
+	// secondary command buffer starts with nothing bound
+	const material* boundMaterial{};
+
+	const size_t last = std::min(first + count, _items.size());
+	if (first < last)
+	{
+		renderer::get()->bindGeometry(commandBuffer);
+		++stats._geometryBinds;
+	}
+
+	for (size_t i = first; i < last; ++i)
+	{
+		const auto& drawItem = _items[i];
+		const auto matInst = drawItem._scene->getMaterialInstance(drawItem._materialIndex);
+		const auto mat = matInst->getMaterial();
+
+		// pipeline, global sets, material instance sets and geometry, as if every draw bound its whole state
+		stats._requestedBinds += 1 + constants::descriptors::globalSetCount + 1 + 1;
+
+		if (mat != boundMaterial)
+		{
+			if (!mat->bindCmd(commandBuffer))
+				continue;
+			boundMaterial = mat;
+			++stats._pipelineBinds;
+		}
+
+		// every material of scene has its own instance, so consecutive draws never share it
+		matInst->bindCmd(commandBuffer);
+		++stats._descriptorSetBinds;
+
+		drawItem._scene->drawMaterial(commandBuffer, drawItem._materialIndex);
+		++stats._draws;
+	}
+}
\ No newline at end of file
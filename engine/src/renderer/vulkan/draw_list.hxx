@@ -0,0 +1,59 @@
+#pragma once
+#include "math/frustum.hxx"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace de::vulkan
+{
+	class material;
+	class scene;
+
+	// binds draws of view frame asked for and binds recorded once redundant ones dropped
+	struct draw_stats
+	{
+		uint32_t _draws{};
+		uint32_t _requestedBinds{};
+		uint32_t _pipelineBinds{};
+		uint32_t _descriptorSetBinds{};
+		uint32_t _geometryBinds{};
+
+		uint32_t getRecordedBinds() const { return _pipelineBinds + _descriptorSetBinds + _geometryBinds; }
+
+		draw_stats& operator+=(const draw_stats& other);
+
+		bool operator==(const draw_stats&) const = default;
+	};
+
+	// visible materials of every scene drawn in view, sorted so consecutive draws share as much bound state as possible
+	class draw_list final
+	{
+	public:
+		// from most significant bits: view 4, pipeline 12, descriptor set 16, depth 32.
+		// geometry of every scene in single buffer bound once, so it takes no bits
+		static uint64_t makeKey(uint32_t view, uint32_t pipeline, uint32_t descriptorSet, float depth);
+
+		// depth is distance of material bounds center to near plane of frustum, so draws of the same sets go front to back
+		void build(uint32_t viewIndex, const std::vector<std::unique_ptr<scene>>& scenes, const de::math::frustum& frustum);
+
+		size_t size() const { return _items.size(); }
+
+		// records draws in range to command buffer, geometry bound once and state bound by previous draw of the range not bound again
+		void record(vk::CommandBuffer commandBuffer, size_t first, size_t count, draw_stats& stats) const;
+
+	private:
+		struct item
+		{
+			uint64_t _key{};
+			const scene* _scene{};
+			uint32_t _materialIndex{};
+		};
+
+		std::vector<item> _items;
+
+		// index is pipeline bits of key
+		std::vector<const material*> _materials;
+	};
+} // namespace de::vulkan
\ No newline at end of file
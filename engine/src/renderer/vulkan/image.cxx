@@ -28,24 +28,19 @@ void de::vulkan::image::destroy()
 
 void de::vulkan::image::createImage(const vk::Device device, const vk::Format format, const uint32_t width, const uint32_t height, const vk::SampleCountFlagBits samples)
 {
-	const auto renderer{renderer::get()};
-	const auto sharingMode{renderer->getSharingMode()};
-	const auto queueIndexes{renderer->getQueueFamilyIndices()};
-
 	const vk::ImageCreateInfo imageCreateInfo =
 		vk::ImageCreateInfo()
 			.setFlags(getImageCreateFlags())
 			.setImageType(vk::ImageType::e2D)
 			.setFormat(format)
 			.setExtent(vk::Extent3D(width, height, 1))
-			.setMipLevels(1)
+			.setMipLevels(getMipLevels())
 			.setArrayLayers(getLayerCount())
 			.setSamples(samples)
 			.setTiling(vk::ImageTiling::eOptimal)
 			.setUsage(getImageUsageFlags())
 			.setInitialLayout(vk::ImageLayout::eUndefined)
-			.setQueueFamilyIndices(queueIndexes)
-			.setSharingMode(sharingMode);
+			.setSharingMode(vk::SharingMode::eExclusive);
 
 	_image = device.createImage(imageCreateInfo);
 }
@@ -63,7 +58,7 @@ void de::vulkan::image::createImageView(const vk::Device device, const vk::Forma
 			.setBaseArrayLayer(0)
 			.setBaseMipLevel(0)
 			.setLayerCount(getLayerCount())
-			.setLevelCount(1);
+			.setLevelCount(getMipLevels());
 
 	const vk::ImageViewCreateInfo imageViewCreateInfo =
 		vk::ImageViewCreateInfo()
@@ -79,13 +74,13 @@ void de::vulkan::image::createImageView(const vk::Device device, const vk::Forma
 VkCommandBuffer de::vulkan::image::transitionImageLayout(const image_transition_layout_info& info)
 {
 	const auto renderer{renderer::get()};
-	vk::CommandBuffer commandBuffer = renderer->beginSingleTimeTransferCommands();
+	vk::CommandBuffer commandBuffer = renderer->beginSingleTimeGraphicsCommands();
 	const vk::ImageSubresourceRange imageSubresourceRange =
 		vk::ImageSubresourceRange()
 			.setAspectMask(info._imageAspectFlags)
 			.setBaseMipLevel(0)
 			.setBaseArrayLayer(0)
-			.setLevelCount(1)
+			.setLevelCount(getMipLevels())
 			.setLayerCount(getLayerCount());
 
 	const vk::ImageMemoryBarrier imageMemoryBarrier =
@@ -42,6 +42,8 @@ namespace de::vulkan
 
 		virtual uint32_t getLayerCount() const { return 1; }
 
+		virtual uint32_t getMipLevels() const { return 1; }
+
 		virtual vk::ImageCreateFlags getImageCreateFlags() const { return {}; }
 
 		virtual vk::ImageViewType getImageViewType() const { return vk::ImageViewType::e2D; }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer/vulkan/image.hxx"
+#include "renderer/vulkan/uploader.hxx"
 
 #include <array>
 #include <string>
@@ -15,6 +16,8 @@ namespace de::vulkan
 
 		void destroy() override;
 
+		uploader::ticket getUploadTicket() const { return _uploadTicket; }
+
 	protected:
 		vk::ImageAspectFlags getImageAspectFlags() const override { return vk::ImageAspectFlagBits::eColor; }
 
@@ -25,5 +28,8 @@ namespace de::vulkan
 		virtual vk::ImageCreateFlags getImageCreateFlags() const override { return vk::ImageCreateFlagBits::eCubeCompatible; }
 
 		virtual vk::ImageViewType getImageViewType() const override { return vk::ImageViewType::eCube; }
+
+	private:
+		uploader::ticket _uploadTicket{};
 	};
 } // namespace de::vulkan
\ No newline at end of file
@@ -25,6 +25,12 @@ void de::vulkan::vk_depth_image::create(uint32_t viewIndex)
 
 	createImageView(device, _format);
 
+	_depthView = device.createImageView(vk::ImageViewCreateInfo()
+											.setImage(_image)
+											.setFormat(_format)
+											.setViewType(vk::ImageViewType::e2D)
+											.setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1)));
+
 	image_transition_layout_info transitionImageLayoutInfo;
 	transitionImageLayoutInfo._image = _image;
 	transitionImageLayoutInfo._format = _format;
@@ -37,9 +43,9 @@ void de::vulkan::vk_depth_image::create(uint32_t viewIndex)
 	transitionImageLayoutInfo._imageAspectFlags = getImageAspectFlags();
 
 	vk::CommandBuffer commandBuffer = transitionImageLayout(transitionImageLayoutInfo);
-	renderer->submitSingleTimeTransferCommands(commandBuffer);
+	renderer->submitSingleTimeGraphicsCommands(commandBuffer);
 
-	device.freeCommandBuffers(renderer->getTransferCommandPool(), commandBuffer);
+	device.freeCommandBuffers(renderer->getGraphicsCommandPool(), commandBuffer);
 }
 
 void de::vulkan::vk_depth_image::recreate()
@@ -48,6 +54,16 @@ void de::vulkan::vk_depth_image::recreate()
 	create(_viewIndex);
 }
 
+void de::vulkan::vk_depth_image::destroy()
+{
+	if (_depthView)
+	{
+		renderer::get()->getDevice().destroyImageView(_depthView);
+		_depthView = nullptr;
+	}
+	image::destroy();
+}
+
 vk::Format de::vulkan::vk_depth_image::getFormat() const
 {
 	return _format;
@@ -60,7 +76,7 @@ vk::ImageAspectFlags de::vulkan::vk_depth_image::getImageAspectFlags() const
 
 vk::ImageUsageFlags de::vulkan::vk_depth_image::getImageUsageFlags() const
 {
-	return vk::ImageUsageFlagBits::eDepthStencilAttachment;
+	return vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled;
 }
 
 bool de::vulkan::vk_depth_image::hasStencilComponent() const
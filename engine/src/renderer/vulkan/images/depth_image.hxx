@@ -7,12 +7,22 @@ namespace de::vulkan
 	class vk_depth_image final : public image
 	{
 	public:
+		vk_depth_image() = default;
+		vk_depth_image(const vk_depth_image&) = delete;
+		vk_depth_image(vk_depth_image&&) = default;
+		virtual ~vk_depth_image() { destroy(); };
+
 		void create(uint32_t viewIndex);
 
 		void recreate();
 
+		void destroy() override;
+
 		vk::Format getFormat() const;
 
+		// depth aspect only, so image could be sampled even if format has stencil
+		vk::ImageView getDepthView() const { return _depthView; }
+
 	protected:
 		vk::ImageAspectFlags getImageAspectFlags() const override;
 
@@ -25,6 +35,8 @@ namespace de::vulkan
 	private:
 		vk::Format _format{VK_FORMAT_UNDEFINED};
 
+		vk::ImageView _depthView;
+
 		uint32_t _viewIndex{};
 	};
 } // namespace de::vulkan
\ No newline at end of file
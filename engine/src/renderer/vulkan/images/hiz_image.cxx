@@ -0,0 +1,92 @@
+#include "hiz_image.hxx"
+
+#include "renderer/vulkan/renderer.hxx"
+#include "renderer/vulkan/utils.hxx"
+
+#include <algorithm>
+#include <bit>
+
+void de::vulkan::vk_hiz_image::create(uint32_t viewIndex)
+{
+	renderer* renderer{renderer::get()};
+	const vk::Device device = renderer->getDevice();
+
+	const auto viewExtent = renderer->getView(viewIndex)->getCurrentExtent();
+	_extent = vk::Extent2D(std::max(1U, (viewExtent.width + 1) / 2), std::max(1U, (viewExtent.height + 1) / 2));
+	_mipCount = std::bit_width(std::max(_extent.width, _extent.height));
+
+	createImage(device, getFormat(), _extent.width, _extent.height);
+
+	const vk::MemoryRequirements memoryRequirements = device.getImageMemoryRequirements(_image);
+	_deviceMemory.allocate(memoryRequirements, utils::memory_property::device);
+
+	bindToMemory(device, _deviceMemory.get(), 0);
+
+	createImageView(device, getFormat());
+
+	_mipViews.resize(_mipCount);
+	for (uint32_t i = 0; i < _mipCount; ++i)
+	{
+		_mipViews[i] = device.createImageView(vk::ImageViewCreateInfo()
+												  .setImage(_image)
+												  .setFormat(getFormat())
+												  .setViewType(vk::ImageViewType::e2D)
+												  .setSubresourceRange(vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, i, 1, 0, 1)));
+	}
+
+	// point sampling, every mip read separately
+	_sampler = device.createSampler(vk::SamplerCreateInfo()
+										.setMagFilter(vk::Filter::eNearest)
+										.setMinFilter(vk::Filter::eNearest)
+										.setMipmapMode(vk::SamplerMipmapMode::eNearest)
+										.setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+										.setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+										.setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+										.setMinLod(0.0F)
+										.setMaxLod(static_cast<float>(_mipCount)));
+
+	image_transition_layout_info transitionImageLayoutInfo;
+	transitionImageLayoutInfo._image = _image;
+	transitionImageLayoutInfo._format = getFormat();
+	transitionImageLayoutInfo._layoutOld = vk::ImageLayout::eUndefined;
+	transitionImageLayoutInfo._layoutNew = vk::ImageLayout::eGeneral;
+	transitionImageLayoutInfo._accessFlagsSrc = vk::AccessFlagBits();
+	transitionImageLayoutInfo._accessFlagsDst = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+	transitionImageLayoutInfo._pipelineStageFlagsSrc = vk::PipelineStageFlagBits::eTopOfPipe;
+	transitionImageLayoutInfo._pipelineStageFlagsDst = vk::PipelineStageFlagBits::eComputeShader;
+	transitionImageLayoutInfo._imageAspectFlags = getImageAspectFlags();
+
+	vk::CommandBuffer commandBuffer = transitionImageLayout(transitionImageLayoutInfo);
+	renderer->submitSingleTimeGraphicsCommands(commandBuffer);
+
+	device.freeCommandBuffers(renderer->getGraphicsCommandPool(), commandBuffer);
+}
+
+void de::vulkan::vk_hiz_image::destroy()
+{
+	if (!_mipViews.empty())
+	{
+		const vk::Device device = renderer::get()->getDevice();
+		for (auto mipView : _mipViews)
+		{
+			device.destroyImageView(mipView);
+		}
+		_mipViews.clear();
+	}
+	image::destroy();
+}
+
+vk::Extent2D de::vulkan::vk_hiz_image::getMipExtent(uint32_t mip) const
+{
+	return vk::Extent2D(std::max(1U, _extent.width >> mip), std::max(1U, _extent.height >> mip));
+}
+
+vk::ImageAspectFlags de::vulkan::vk_hiz_image::getImageAspectFlags() const
+{
+	return vk::ImageAspectFlagBits::eColor;
+}
+
+vk::ImageUsageFlags de::vulkan::vk_hiz_image::getImageUsageFlags() const
+{
+	return vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled;
+}
\ No newline at end of file
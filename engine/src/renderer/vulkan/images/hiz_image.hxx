@@ -0,0 +1,47 @@
+#pragma once
+
+#include "renderer/vulkan/image.hxx"
+
+#include <vector>
+
+namespace de::vulkan
+{
+	// farthest depth pyramid of view, mip 0 is half of view extent. Always in general layout, written and sampled by compute shaders
+	class vk_hiz_image final : public image
+	{
+	public:
+		vk_hiz_image() = default;
+		vk_hiz_image(const vk_hiz_image&) = delete;
+		vk_hiz_image(vk_hiz_image&&) = default;
+		virtual ~vk_hiz_image() { destroy(); };
+
+		void create(uint32_t viewIndex);
+
+		void destroy() override;
+
+		vk::Format getFormat() const { return vk::Format::eR32Sfloat; }
+
+		vk::Extent2D getExtent() const { return _extent; }
+
+		vk::Extent2D getMipExtent(uint32_t mip) const;
+
+		uint32_t getMipCount() const { return _mipCount; }
+
+		// single mip view, for storage image bindings
+		vk::ImageView getMipView(uint32_t mip) const { return _mipViews[mip]; }
+
+	protected:
+		vk::ImageAspectFlags getImageAspectFlags() const override;
+
+		vk::ImageUsageFlags getImageUsageFlags() const override;
+
+		uint32_t getMipLevels() const override { return _mipCount; }
+
+	private:
+		vk::Extent2D _extent{};
+
+		uint32_t _mipCount{1};
+
+		std::vector<vk::ImageView> _mipViews;
+	};
+} // namespace de::vulkan
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "gltf/image.hxx"
+#include "renderer/vulkan/bindless_heap.hxx"
 #include "renderer/vulkan/image.hxx"
+#include "renderer/vulkan/uploader.hxx"
 
 namespace de::vulkan
 {
@@ -17,15 +19,21 @@ namespace de::vulkan
 
 		void destroy() override;
 
-		vk::Sampler getSampler() const;
-
 		bool isValid() const;
 
+		uploader::ticket getUploadTicket() const { return _uploadTicket; }
+
+		// slot in bindless heap, sample it only once upload complete
+		uint32_t getBindlessIndex() const { return _bindlessIndex; }
+
 	protected:
 		virtual vk::ImageAspectFlags getImageAspectFlags() const override;
 
 		virtual vk::ImageUsageFlags getImageUsageFlags() const override;
 
-		vk::Sampler _sampler;
+	private:
+		uploader::ticket _uploadTicket{};
+
+		uint32_t _bindlessIndex{bindless_heap::invalidIndex};
 	};
 } // namespace de::vulkan
\ No newline at end of file
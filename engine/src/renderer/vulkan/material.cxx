@@ -1,18 +1,30 @@
 #include "material.hxx"
 
+#include "constants.hxx"
 #include "dreco.hxx"
 #include "renderer.hxx"
 
+#include <algorithm>
+
 de::vulkan::material::~material()
 {
 	auto device = renderer::get()->getDevice();
-	if (_descriptorPool)
+	destroyDescriptorSetLayouts();
+	for (const auto& pool : _descriptorPools)
+	{
+		device.destroyDescriptorPool(pool._pool);
+	}
+
+	// pipeline workers stopped before materials destroyed, so pending tasks not executing
+	for (auto& task : _pendingPipelines)
 	{
-		for (auto layout : _descriptorSetLayouts)
-			device.destroyDescriptorSetLayout(layout);
-		device.destroyDescriptorPool(_descriptorPool);
+		task->unbindAll();
+		task->abort();
+		task->destroy();
 	}
+	_pendingPipelines.clear();
 
+	_viewPipelines.clear();
 	_pipelines.clear();
 
 	if (_pipelineLayout)
@@ -23,17 +35,63 @@ de::vulkan::material::~material()
 
 void de::vulkan::material::viewAdded(uint32_t viewIndex)
 {
-	_pipelines.emplace(viewIndex, createPipeline(viewIndex));
+	const auto key = pipeline_key::makeFromView(*renderer::get()->getView(viewIndex));
+	_viewPipelines.emplace(viewIndex, view_pipeline{key, acquirePipeline(key)});
 }
 
 void de::vulkan::material::viewUpdated(uint32_t viewIndex)
 {
-	_pipelines.at(viewIndex) = createPipeline(viewIndex);
+	// swapchain resize keeps render pass compatible, so only framebuffers recreated
+	auto& viewPipeline = _viewPipelines.at(viewIndex);
+	const auto key = pipeline_key::makeFromView(*renderer::get()->getView(viewIndex));
+	if (viewPipeline._key == key)
+		return;
+
+	const auto oldKey = viewPipeline._key;
+	viewPipeline = view_pipeline{key, acquirePipeline(key)};
+	releasePipeline(oldKey);
 }
 
 void de::vulkan::material::viewRemoved(uint32_t viewIndex)
 {
-	_pipelines.erase(viewIndex);
+	const auto it = _viewPipelines.find(viewIndex);
+	if (it == _viewPipelines.end())
+		return;
+
+	const auto key = it->second._key;
+	_viewPipelines.erase(it);
+	releasePipeline(key);
+}
+
+const de::vulkan::material::shared_pipeline* de::vulkan::material::acquirePipeline(const pipeline_key& key)
+{
+	auto& shared = _pipelines[key];
+	if (!shared._pipeline && !shared._task)
+	{
+		shared._task = createPipeline(key);
+	}
+	++shared._viewCount;
+	return &shared;
+}
+
+void de::vulkan::material::releasePipeline(const pipeline_key& key)
+{
+	const auto it = _pipelines.find(key);
+	if (it == _pipelines.end() || --it->second._viewCount != 0)
+		return;
+
+	// compiling one destroyed once its task completed
+	if (it->second._task)
+	{
+		it->second._task->abort();
+	}
+	else
+	{
+		auto renderer = renderer::get();
+		renderer->deferDestroy([device = renderer->getDevice(), pipeline = it->second._pipeline.release()]()
+			{ device.destroyPipeline(pipeline); });
+	}
+	_pipelines.erase(it);
 }
 
 de::vulkan::material::unique de::vulkan::material::makeNew(shader::shared vert, shader::shared frag)
@@ -46,28 +104,28 @@ de::vulkan::material::unique de::vulkan::material::makeNew(shader::shared vert,
 
 de::vulkan::material_instance* de::vulkan::material::makeInstance()
 {
-	material_instance::unique newMatInst{};
-	try
+	auto& inst = _instances.emplace_back(new material_instance(this));
+	return inst.get();
+}
+
+void de::vulkan::material::removeInstance(material_instance* instance)
+{
+	const auto it = std::find_if(_instances.begin(), _instances.end(), [instance](const material_instance::unique& inst)
+		{ return inst.get() == instance; });
+	if (it == _instances.end())
 	{
-		newMatInst = material_instance::unique(new material_instance(this));
+		DE_LOG(Error, "%s: instance does not belong to material", __FUNCTION__);
+		return;
 	}
-	catch (vk::OutOfPoolMemoryError)
-	{
-		DE_LOG(Error, "%s: Out of descriptor pool memory. Resizing. . .", __FUNCTION__);
-
-		const auto maxSetsBeforeResize = _depscriptorPoolMaxSets;
-		resizeDescriptorPool(maxSetsBeforeResize * 2);
 
-		// second attempt to create instance, but without handling throw
-		newMatInst = material_instance::unique(new material_instance(this));
-	}
-	auto& inst = _instances.emplace_back(std::move(newMatInst));
-	return inst.get();
+	(*it)->retire();
+	_instances.erase(it);
 }
 
 void de::vulkan::material::init(size_t maxInstances)
 {
-	createDescriptorPool(maxInstances);
+	_instancesPerDescriptorPool = std::max<uint32_t>(maxInstances, 1);
+	createDescriptorSetLayouts();
 	createPipelineLayout();
 
 	const auto& views = renderer::get()->getViews();
@@ -80,7 +138,7 @@ void de::vulkan::material::init(size_t maxInstances)
 
 void de::vulkan::material::setDynamicStates(std::vector<vk::DynamicState>&& dynamicStates)
 {
-	_pipelineDynamicStates = dynamicStates;
+	_pipelineDynamicStates = std::move(dynamicStates);
 }
 
 void de::vulkan::material::setShaderVert(const shader::shared& inShader)
@@ -93,72 +151,271 @@ void de::vulkan::material::setShaderFrag(const shader::shared& inShader)
 	_frag = inShader;
 }
 
-void de::vulkan::material::resizeDescriptorPool(uint32_t newSize)
+void de::vulkan::material::allocateDescriptorSets(uint32_t& poolIndex, vk::DescriptorSet* outSets)
 {
-	auto device = renderer::get()->getDevice();
+	poolIndex = UINT32_MAX;
+	if (_instanceSetLayouts.empty())
+		return;
 
-	// free all instances (unnecessary)
-	for (auto& instance : _instances)
-		instance->free();
+	const auto allocateInfo = vk::DescriptorSetAllocateInfo()
+								  .setSetLayouts(_instanceSetLayouts);
 
-	for (auto layout : _descriptorSetLayouts)
-		device.destroyDescriptorSetLayout(layout);
-	_descriptorSetLayouts.clear();
+	auto device = renderer::get()->getDevice();
+	while (true)
+	{
+		if (_currentDescriptorPool == _descriptorPools.size())
+		{
+			DE_LOG(Info, "%s: Adding descriptor pool %u", __FUNCTION__, _currentDescriptorPool);
+			_descriptorPools.push_back(descriptor_pool{createDescriptorPool()});
+		}
 
-	device.destroyDescriptorPool(_descriptorPool);
+		auto& pool = _descriptorPools[_currentDescriptorPool];
+		if (pool._allocated < _instancesPerDescriptorPool)
+		{
+			// written straight to caller storage, nothing allocated on heap
+			const auto info = vk::DescriptorSetAllocateInfo(allocateInfo).setDescriptorPool(pool._pool);
+			const vk::Result result = device.allocateDescriptorSets(&info, outSets);
+			if (result == vk::Result::eSuccess)
+			{
+				++pool._allocated;
+				++pool._live;
+				poolIndex = _currentDescriptorPool;
+				return;
+			}
+
+			// pool sized for its instances, so fresh one never runs out
+			if (result != vk::Result::eErrorOutOfPoolMemory || pool._allocated == 0)
+			{
+				throw vk::SystemError(vk::make_error_code(result), __FUNCTION__);
+			}
+		}
+
+		// continue with emptied pool if there is one, new pool added otherwise
+		const auto emptyPool = std::find_if(_descriptorPools.begin(), _descriptorPools.end(), [](const descriptor_pool& p)
+			{ return p._allocated == 0; });
+		_currentDescriptorPool = std::distance(_descriptorPools.begin(), emptyPool);
+	}
+}
 
-	createDescriptorPool(newSize);
+void de::vulkan::material::releaseDescriptorSets(uint32_t poolIndex)
+{
+	if (poolIndex >= _descriptorPools.size())
+		return;
 
-	// re-allocate with new pool and update all sets
-	for (auto& instance : _instances)
+	auto& pool = _descriptorPools[poolIndex];
+	if (--pool._live == 0)
 	{
-		instance->allocate();
-		instance->updateDescriptorSets();
+		renderer::get()->getDevice().resetDescriptorPool(pool._pool);
+		pool._allocated = 0;
 	}
-		
 }
 
-void de::vulkan::material::bindCmd(vk::CommandBuffer commandBuffer) const
+bool de::vulkan::material::bindCmd(vk::CommandBuffer commandBuffer) const
+{
+	const auto& pipeline = _viewPipelines.at(renderer::get()->getCurrentDrawViewIndex())._shared->_pipeline;
+	if (!pipeline)
+		return false;
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.get());
+	return true;
+}
+
+void de::vulkan::material::createDescriptorSetLayouts()
 {
 	auto renderer = renderer::get();
-	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, _pipelines.at(renderer->getCurrentDrawViewIndex()).get());
+	auto device = renderer->getDevice();
+
+	// stages could declare bindings of the same set, merged to single layout of it
+	struct merged_set
+	{
+		std::vector<vk::DescriptorSetLayoutBinding> _bindings;
+		bool _bindless{false};
+	};
+	std::map<uint32_t, merged_set> mergedSets;
+	for (const auto& stageShader : {_vert, _frag})
+	{
+		for (const auto& data : stageShader->getDescirptorShaderData())
+		{
+			auto& mergedSet = mergedSets[data._descriptorSetIndex];
+			mergedSet._bindless |= data._bindless;
+			for (const auto& binding : data._descriptorSetLayoutBindings)
+			{
+				const auto it = std::find_if(mergedSet._bindings.begin(), mergedSet._bindings.end(), [&binding](const vk::DescriptorSetLayoutBinding& merged)
+					{ return merged.binding == binding.binding; });
+				if (it != mergedSet._bindings.end())
+					it->stageFlags |= binding.stageFlags;
+				else
+					mergedSet._bindings.push_back(binding);
+			}
+		}
+	}
+
+	// global sets included even if shaders don't use them, so they stay the same for every material
+	const uint32_t setCount = std::max(mergedSets.empty() ? 0 : mergedSets.rbegin()->first + 1, constants::descriptors::globalSetCount);
+	_globalDescriptorSets.assign(setCount, vk::DescriptorSet());
+
+	for (uint32_t i = 0; i < setCount; ++i)
+	{
+		const auto it = mergedSets.find(i);
+		if (i == constants::descriptors::frameSet)
+		{
+			if (it != mergedSets.end() && std::any_of(it->second._bindings.begin(), it->second._bindings.end(), [](const vk::DescriptorSetLayoutBinding& binding)
+											   { return binding.binding != 0 || binding.descriptorType != vk::DescriptorType::eUniformBufferDynamic; }))
+			{
+				DE_LOG(Error, "%s: set %u of %s reserved for per frame data, only %s expected in it", __FUNCTION__, i, _vert->getPath().data(), constants::descriptors::cameraData);
+			}
+			_descriptorSetLayouts.push_back(renderer->getFrameDescriptorSetLayout());
+			_globalDescriptorSets[i] = renderer->getFrameDescriptorSet();
+		}
+		else if (i == constants::descriptors::bindlessSet)
+		{
+			if (it != mergedSets.end() && !it->second._bindless)
+			{
+				DE_LOG(Error, "%s: set %u of %s reserved for bindless heap, only %s expected in it", __FUNCTION__, i, _vert->getPath().data(), constants::descriptors::textures);
+			}
+			_descriptorSetLayouts.push_back(renderer->getBindlessHeap().getLayout());
+			_globalDescriptorSets[i] = renderer->getBindlessHeap().getSet();
+		}
+		else
+		{
+			if (it != mergedSets.end() && it->second._bindless)
+			{
+				DE_LOG(Error, "%s: %s of %s expected in set %u, not %u", __FUNCTION__, constants::descriptors::textures, _vert->getPath().data(), constants::descriptors::bindlessSet, i);
+			}
+
+			// set numbers shaders skip get empty layout
+			const auto bindings = it != mergedSets.end() ? it->second._bindings : std::vector<vk::DescriptorSetLayoutBinding>();
+			_descriptorSetLayouts.push_back(device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo().setBindings(bindings)));
+			_instanceSetLayouts.push_back(_descriptorSetLayouts.back());
+			for (const auto& binding : bindings)
+			{
+				_instancePoolSizes.emplace_back(binding.descriptorType, binding.descriptorCount);
+			}
+		}
+	}
+
+	createBindingSlots();
+	createDescriptorUpdateTemplates();
 }
 
-void de::vulkan::material::createDescriptorPool(uint32_t maxSets)
+void de::vulkan::material::createBindingSlots()
 {
-	_depscriptorPoolMaxSets = maxSets;
+	_bindingSlots.clear();
+	for (const auto& stageShader : {_vert, _frag})
+	{
+		const auto& refl = stageShader->getRefl();
+		for (uint32_t i = 0; i < refl.descriptor_binding_count; ++i)
+		{
+			const auto& reflBinding = refl.descriptor_bindings[i];
+			if (isGlobalDescriptorSet(reflBinding.set))
+				continue;
+
+			const bool isMerged = std::any_of(_bindingSlots.begin(), _bindingSlots.end(), [&reflBinding](const descriptor_binding_slot& slot)
+				{ return slot._set == reflBinding.set && slot._binding == reflBinding.binding; });
+			if (isMerged)
+				continue;
+
+			auto& slot = _bindingSlots.emplace_back();
+			slot._name = reflBinding.name;
+			slot._set = reflBinding.set;
+			slot._binding = reflBinding.binding;
+			slot._count = reflBinding.count;
+			slot._type = shader::getDescriptorType(reflBinding);
+			if (slot._type == vk::DescriptorType::eUniformBufferDynamic)
+			{
+				slot._range = reflBinding.block.size;
+			}
+		}
+	}
+
+	// set and binding order is order of dynamic offsets as well
+	std::sort(_bindingSlots.begin(), _bindingSlots.end(), [](const descriptor_binding_slot& a, const descriptor_binding_slot& b)
+		{ return a._set != b._set ? a._set < b._set : a._binding < b._binding; });
+
+	auto renderer = renderer::get();
+	_instanceDescriptorCount = 0;
+	_dynamicStrides.clear();
+	_dynamicCounts.assign(_descriptorSetLayouts.size(), 0);
+	for (auto& slot : _bindingSlots)
+	{
+		slot._firstDescriptor = _instanceDescriptorCount;
+		_instanceDescriptorCount += slot._count;
 
+		if (slot._type == vk::DescriptorType::eUniformBufferDynamic)
+		{
+			_dynamicStrides.push_back(renderer->getFrameSliceStride(slot._range));
+			++_dynamicCounts[slot._set];
+		}
+	}
+}
+
+void de::vulkan::material::createDescriptorUpdateTemplates()
+{
 	auto device = renderer::get()->getDevice();
-	std::vector<shader::descripted_data> shadersDataSets;
+
+	_descriptorUpdateTemplates.assign(_descriptorSetLayouts.size(), vk::DescriptorUpdateTemplate());
+	for (uint32_t i = 0; i < _descriptorSetLayouts.size(); ++i)
 	{
-		auto dataSets = _vert->getDescirptorShaderData();
-		std::move(dataSets.begin(), dataSets.end(), std::back_inserter(shadersDataSets));
+		std::vector<vk::DescriptorUpdateTemplateEntry> entries;
+		for (const auto& slot : _bindingSlots)
+		{
+			if (slot._set == i)
+			{
+				entries.emplace_back(slot._binding, 0, slot._count, slot._type, slot._firstDescriptor * sizeof(descriptor_info), sizeof(descriptor_info));
+			}
+		}
+		if (entries.empty())
+			continue;
+
+		_descriptorUpdateTemplates[i] = device.createDescriptorUpdateTemplate(vk::DescriptorUpdateTemplateCreateInfo()
+																				  .setDescriptorUpdateEntries(entries)
+																				  .setTemplateType(vk::DescriptorUpdateTemplateType::eDescriptorSet)
+																				  .setDescriptorSetLayout(_descriptorSetLayouts[i]));
 	}
+}
+
+void de::vulkan::material::destroyDescriptorSetLayouts()
+{
+	auto device = renderer::get()->getDevice();
+	for (auto updateTemplate : _descriptorUpdateTemplates)
 	{
-		auto dataSets = _frag->getDescirptorShaderData();
-		std::move(dataSets.begin(), dataSets.end(), std::back_inserter(shadersDataSets));
+		if (updateTemplate)
+			device.destroyDescriptorUpdateTemplate(updateTemplate);
 	}
+	_descriptorUpdateTemplates.clear();
 
-	std::vector<vk::DescriptorPoolSize> poolSizes;
-	for (const auto& data : shadersDataSets)
+	for (uint32_t i = 0; i < _descriptorSetLayouts.size(); ++i)
 	{
-		_descriptorSetLayouts.push_back(device.createDescriptorSetLayout(data._descriptorSetLayoutCreateInfo));
+		if (!isGlobalDescriptorSet(i))
+			device.destroyDescriptorSetLayout(_descriptorSetLayouts[i]);
+	}
+	_descriptorSetLayouts.clear();
+	_instanceSetLayouts.clear();
+}
 
-		auto dataPoolSizes = data.getDescriptorPoolSizes(_depscriptorPoolMaxSets);
-		std::move(dataPoolSizes.begin(), dataPoolSizes.end(), std::back_inserter(poolSizes));
+vk::DescriptorPool de::vulkan::material::createDescriptorPool() const
+{
+	std::vector<vk::DescriptorPoolSize> poolSizes = _instancePoolSizes;
+	for (auto& poolSize : poolSizes)
+	{
+		poolSize.descriptorCount *= _instancesPerDescriptorPool;
 	}
 
-	_descriptorPool = device.createDescriptorPool(vk::DescriptorPoolCreateInfo()
-													  .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet)
-													  .setPoolSizes(poolSizes)
-													  .setMaxSets(_descriptorSetLayouts.size() * _depscriptorPoolMaxSets));
+	return renderer::get()->getDevice().createDescriptorPool(vk::DescriptorPoolCreateInfo()
+																 .setPoolSizes(poolSizes)
+																 .setMaxSets(_instanceSetLayouts.size() * _instancesPerDescriptorPool));
 }
 
 void de::vulkan::material::createPipelineLayout()
 {
 	auto device = renderer::get()->getDevice();
 
+	// global sets bound with renderer layout that has no push constants, ranges would break compatibility with it
 	const auto ranges = getPushConstantRanges();
+	if (!ranges.empty())
+	{
+		DE_LOG(Error, "%s: push constants of %s make global sets incompatible, they won't stay bound", __FUNCTION__, _vert->getPath().data());
+	}
 
 	const vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo =
 		vk::PipelineLayoutCreateInfo()
@@ -173,11 +430,6 @@ const std::vector<vk::DescriptorSetLayout>& de::vulkan::material::getDescriptorS
 	return _descriptorSetLayouts;
 }
 
-vk::DescriptorPool de::vulkan::material::getDescriptorPool() const
-{
-	return _descriptorPool;
-}
-
 std::vector<vk::PushConstantRange> de::vulkan::material::getPushConstantRanges() const
 {
 	std::vector<vk::PushConstantRange> out;
@@ -215,113 +467,128 @@ vk::PipelineLayout de::vulkan::material::getPipelineLayout() const
 	return _pipelineLayout;
 }
 
-vk::UniquePipeline de::vulkan::material::createPipeline(uint32_t viewIndex)
+de::vulkan::material::pipeline_key de::vulkan::material::pipeline_key::makeFromView(const view& v)
 {
-	const renderer* renderer{renderer::get()};
-	auto view = renderer->getView(viewIndex);
+	pipeline_key key;
+	key._colorFormat = v.getFormat();
+	key._depthFormat = v.getDepthImage().getFormat();
+	key._sampleCount = v.getSettings().getSampleCount();
+	key._polygonMode = v.getSettings().getPolygonMode();
+	return key;
+}
 
-	const std::vector<vk::PipelineShaderStageCreateInfo> shaderStages =
-		{
-			_vert->getPipelineShaderStageCreateInfo(),
-			_frag->getPipelineShaderStageCreateInfo(),
-		};
-
-	const auto vertexInputInfo = _vert->getVertexInputInfo();
-	const auto vertexInputState = vk::PipelineVertexInputStateCreateInfo()
-									  .setVertexBindingDescriptions(vertexInputInfo._bindingDesc)
-									  .setVertexAttributeDescriptions(vertexInputInfo._attributeDesc);
-
-	std::array<vk::PipelineColorBlendAttachmentState, 1> colorBlendAttachments;
-	colorBlendAttachments[0] = vk::PipelineColorBlendAttachmentState()
-								   .setBlendEnable(VK_FALSE)
-								   .setColorWriteMask(
-									   vk::ColorComponentFlagBits::eR |
-									   vk::ColorComponentFlagBits::eG |
-									   vk::ColorComponentFlagBits::eB |
-									   vk::ColorComponentFlagBits::eA)
-								   .setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
-								   .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
-								   .setColorBlendOp(vk::BlendOp::eAdd)
-								   .setSrcAlphaBlendFactor(vk::BlendFactor::eSrcAlpha)
-								   .setDstAlphaBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
-								   .setAlphaBlendOp(vk::BlendOp::eSubtract);
-
-	const std::array<float, 4> colorBlendConstants = {0.F, 0.F, 0.F, 0.F};
-
-	const auto colorBlendingState = vk::PipelineColorBlendStateCreateInfo()
-										.setLogicOpEnable(VK_FALSE)
-										.setLogicOp(vk::LogicOp::eCopy)
-										.setAttachments(colorBlendAttachments)
-										.setBlendConstants(colorBlendConstants);
-
-	const auto inputAssemblyState = vk::PipelineInputAssemblyStateCreateInfo()
-										.setTopology(vk::PrimitiveTopology::eTriangleList)
-										.setPrimitiveRestartEnable(VK_FALSE);
-
-	const auto rasterizationState = vk::PipelineRasterizationStateCreateInfo()
-										.setRasterizerDiscardEnable(VK_FALSE)
-										.setPolygonMode(view->getSettings().getPolygonMode())
-										.setLineWidth(1.0F)
-										.setCullMode(vk::CullModeFlagBits::eNone)
-										.setFrontFace(vk::FrontFace::eCounterClockwise)
-										.setDepthClampEnable(VK_FALSE)
-										.setDepthBiasEnable(VK_FALSE)
-										.setDepthBiasConstantFactor(0.0F)
-										.setDepthBiasSlopeFactor(0.0F)
-										.setDepthBiasClamp(0.0F);
-
-	const auto multisamplingState = vk::PipelineMultisampleStateCreateInfo()
-										.setSampleShadingEnable(VK_FALSE)
-										.setRasterizationSamples(view->getSettings().getSampleCount())
-										.setMinSampleShading(1.0F)
-										.setPSampleMask(nullptr)
-										.setAlphaToCoverageEnable(VK_TRUE)
-										.setAlphaToOneEnable(VK_FALSE);
-
-	const auto depthStencilState = vk::PipelineDepthStencilStateCreateInfo()
-									   .setDepthTestEnable(VK_TRUE)
-									   .setDepthWriteEnable(VK_TRUE)
-									   .setDepthCompareOp(vk::CompareOp::eLess)
-									   .setDepthBoundsTestEnable(VK_FALSE)
-									   .setMinDepthBounds(0.0F)
-									   .setMaxDepthBounds(1.0F)
-									   .setStencilTestEnable(VK_TRUE);
-
-	const auto extent = view->getCurrentExtent();
-	const auto viewport = vk::Viewport()
-							  .setX(0)
-							  .setY(0)
-							  .setWidth(extent.width)
-							  .setHeight(extent.height)
-							  .setMinDepth(0.0F)
-							  .setMaxDepth(1.0F);
-
-	const auto scissors = vk::Rect2D()
-							  .setOffset(vk::Offset2D(0, 0))
-							  .setExtent(extent);
-
-	const auto viewportState = vk::PipelineViewportStateCreateInfo()
-								   .setViewports(viewport)
-								   .setScissors(scissors);
-
-	const auto dynamicState = vk::PipelineDynamicStateCreateInfo()
-								  .setDynamicStates(_pipelineDynamicStates);
-
-	const auto pipelineCreateInfo = vk::GraphicsPipelineCreateInfo()
-										.setStages(shaderStages)
-										.setPVertexInputState(&vertexInputState)
-										.setPInputAssemblyState(&inputAssemblyState)
-										.setPViewportState(&viewportState)
-										.setPDynamicState(&dynamicState)
-										.setPRasterizationState(&rasterizationState)
-										.setPColorBlendState(&colorBlendingState)
-										.setPMultisampleState(&multisamplingState)
-										.setPDepthStencilState(&depthStencilState)
-										.setLayout(_pipelineLayout)
-										.setRenderPass(view->getRenderPass())
-										.setSubpass(0);
-
-	auto createPipelineResult = renderer->getDevice().createGraphicsPipelineUnique(nullptr, pipelineCreateInfo);
-	assert(vk::Result::eSuccess == createPipelineResult.result);
-	return std::move(createPipelineResult.value);
+size_t de::vulkan::material::pipeline_key::hash::operator()(const pipeline_key& key) const
+{
+	size_t seed = 0;
+	const auto combine = [&seed](size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	};
+	combine(std::hash<uint32_t>()(static_cast<uint32_t>(key._colorFormat)));
+	combine(std::hash<uint32_t>()(static_cast<uint32_t>(key._depthFormat)));
+	combine(std::hash<uint32_t>()(static_cast<uint32_t>(key._sampleCount)));
+	combine(std::hash<uint32_t>()(static_cast<uint32_t>(key._polygonMode)));
+	return seed;
+}
+
+std::shared_ptr<de::vulkan::async_create_pipeline> de::vulkan::material::createPipeline(const pipeline_key& key)
+{
+	auto renderer{renderer::get()};
+	auto device = renderer->getDevice();
+
+	// pool initializes queued tasks on its tick on this thread, so workers never see task before it filled
+	auto& pool = renderer->getPipelineThreadPool();
+	auto task = std::static_pointer_cast<async_create_pipeline>(pool.queueTask<async_create_pipeline>(device, renderer->getPipelineCache()));
+
+	task->_vert = _vert;
+	task->_frag = _frag;
+	task->_vertexInputInfo = _vert->getVertexInputInfo();
+
+	task->_colorBlendAttachments[0] = vk::PipelineColorBlendAttachmentState()
+										  .setBlendEnable(VK_FALSE)
+										  .setColorWriteMask(
+											  vk::ColorComponentFlagBits::eR |
+											  vk::ColorComponentFlagBits::eG |
+											  vk::ColorComponentFlagBits::eB |
+											  vk::ColorComponentFlagBits::eA)
+										  .setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha)
+										  .setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
+										  .setColorBlendOp(vk::BlendOp::eAdd)
+										  .setSrcAlphaBlendFactor(vk::BlendFactor::eSrcAlpha)
+										  .setDstAlphaBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha)
+										  .setAlphaBlendOp(vk::BlendOp::eSubtract);
+
+	task->_colorBlendState = vk::PipelineColorBlendStateCreateInfo()
+								 .setLogicOpEnable(VK_FALSE)
+								 .setLogicOp(vk::LogicOp::eCopy)
+								 .setBlendConstants({0.F, 0.F, 0.F, 0.F});
+
+	task->_inputAssemblyState = vk::PipelineInputAssemblyStateCreateInfo()
+									.setTopology(vk::PrimitiveTopology::eTriangleList)
+									.setPrimitiveRestartEnable(VK_FALSE);
+
+	task->_rasterizationState = vk::PipelineRasterizationStateCreateInfo()
+									.setRasterizerDiscardEnable(VK_FALSE)
+									.setPolygonMode(key._polygonMode)
+									.setLineWidth(1.0F)
+									.setCullMode(vk::CullModeFlagBits::eNone)
+									.setFrontFace(vk::FrontFace::eCounterClockwise)
+									.setDepthClampEnable(VK_FALSE)
+									.setDepthBiasEnable(VK_FALSE)
+									.setDepthBiasConstantFactor(0.0F)
+									.setDepthBiasSlopeFactor(0.0F)
+									.setDepthBiasClamp(0.0F);
+
+	task->_multisampleState = vk::PipelineMultisampleStateCreateInfo()
+								  .setSampleShadingEnable(VK_FALSE)
+								  .setRasterizationSamples(key._sampleCount)
+								  .setMinSampleShading(1.0F)
+								  .setPSampleMask(nullptr)
+								  .setAlphaToCoverageEnable(VK_TRUE)
+								  .setAlphaToOneEnable(VK_FALSE);
+
+	task->_depthStencilState = vk::PipelineDepthStencilStateCreateInfo()
+								   .setDepthTestEnable(VK_TRUE)
+								   .setDepthWriteEnable(VK_TRUE)
+								   .setDepthCompareOp(vk::CompareOp::eLess)
+								   .setDepthBoundsTestEnable(VK_FALSE)
+								   .setMinDepthBounds(0.0F)
+								   .setMaxDepthBounds(1.0F)
+								   .setStencilTestEnable(VK_TRUE);
+
+	// set by view for every command buffer it begins
+	task->_viewportState = vk::PipelineViewportStateCreateInfo()
+							   .setViewportCount(1)
+							   .setScissorCount(1);
+
+	task->_dynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+	task->_dynamicStates.insert(task->_dynamicStates.end(), _pipelineDynamicStates.begin(), _pipelineDynamicStates.end());
+
+	// views render passes could be recreated before worker picks task, so it owns compatible one
+	task->_renderPass = view::makeRenderPass(device, key._colorFormat, key._depthFormat, key._sampleCount);
+
+	task->_createInfo.setLayout(_pipelineLayout);
+	task->link();
+
+	task->bindCallback([this, key](de::async::thread_task* completed)
+		{ onPipelineCreated(key, static_cast<async_create_pipeline*>(completed)); });
+	_pendingPipelines.push_back(task);
+	return task;
+}
+
+void de::vulkan::material::onPipelineCreated(const pipeline_key& key, async_create_pipeline* task)
+{
+	std::erase_if(_pendingPipelines, [task](const auto& pending)
+		{ return pending.get() == task; });
+
+	// views released pipeline while it was compiling
+	const auto it = _pipelines.find(key);
+	if (it == _pipelines.end() || it->second._task.get() != task)
+	{
+		task->destroy();
+		return;
+	}
+
+	it->second._pipeline = vk::UniquePipeline(task->extract(), renderer::get()->getDevice());
+	it->second._task.reset();
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "images/texture_image.hxx"
 
+#include "async_create_pipeline.hxx"
 #include "buffer.hxx"
 #include "material_instance.hxx"
 #include "shader.hxx"
@@ -9,11 +10,14 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
 namespace de::vulkan
 {
+	class view;
+
 	class material final
 	{
 		material() = default;
@@ -24,6 +28,9 @@ namespace de::vulkan
 		static unique makeNew(shader::shared vert, shader::shared frag);
 		material_instance* makeInstance();
 
+		// sets of instance released once frames in flight done, instance destroyed right away
+		void removeInstance(material_instance* instance);
+
 		void init(size_t maxInstances);
 
 		void setDynamicStates(std::vector<vk::DynamicState>&& dynamicStates);
@@ -36,12 +43,32 @@ namespace de::vulkan
 		void viewUpdated(uint32_t viewIndex);
 		void viewRemoved(uint32_t viewIndex);
 
-		void resizeDescriptorPool(uint32_t newSize);
-
-		void bindCmd(vk::CommandBuffer commandBuffer) const;
+		// binds pipeline only, global sets bound by renderer once per command buffer and instances bind sets they own.
+		// false if pipeline of current view still compiling, draws of material skipped then
+		bool bindCmd(vk::CommandBuffer commandBuffer) const;
 
 		const std::vector<vk::DescriptorSetLayout>& getDescriptorSetLayouts() const;
-		vk::DescriptorPool getDescriptorPool() const;
+
+		// sets instance owns in order of set number, allocated from current pool of the chain. Pool added once every one full, existing sets stay valid
+		void allocateDescriptorSets(uint32_t& poolIndex, vk::DescriptorSet* outSets);
+
+		// call once frames in flight that may use sets done, pool reset for reuse once all its sets released
+		void releaseDescriptorSets(uint32_t poolIndex);
+
+		// sets owned by renderer and shared by every instance: per frame data and bindless heap
+		bool isGlobalDescriptorSet(uint32_t set) const { return set < _globalDescriptorSets.size() && _globalDescriptorSets[set]; }
+		const std::vector<vk::DescriptorSet>& getGlobalDescriptorSets() const { return _globalDescriptorSets; }
+
+		// bindings of owned sets in order of set and binding, instances keep descriptors of them in flat array of that size
+		const std::vector<descriptor_binding_slot>& getBindingSlots() const { return _bindingSlots; }
+		uint32_t getInstanceDescriptorCount() const { return _instanceDescriptorCount; }
+
+		// writes owned set from instance descriptors array, null for global sets and sets without bindings
+		vk::DescriptorUpdateTemplate getDescriptorUpdateTemplate(uint32_t set) const { return _descriptorUpdateTemplates[set]; }
+
+		// slice stride of every dynamic binding in order of binding slots and count of them in every set
+		const std::vector<vk::DeviceSize>& getDynamicStrides() const { return _dynamicStrides; }
+		const std::vector<uint32_t>& getDynamicCounts() const { return _dynamicCounts; }
 
 		std::vector<vk::PushConstantRange> getPushConstantRanges() const;
 		std::vector<vk::PipelineShaderStageCreateInfo> getShaderStages() const;
@@ -56,22 +83,100 @@ namespace de::vulkan
 		void setShaderFrag(const shader::shared& inShader);
 		void setInstanceCount(uint32_t inValue);
 
-		void createDescriptorPool(uint32_t maxSets = 1);
+		void createDescriptorSetLayouts();
+
+		void createBindingSlots();
+
+		void createDescriptorUpdateTemplates();
+
+		// except layouts of global sets
+		void destroyDescriptorSetLayouts();
+
+		vk::DescriptorPool createDescriptorPool() const;
 
 		void createPipelineLayout();
 
-		vk::UniquePipeline createPipeline(uint32_t viewIndex);
+		// state of view pipeline baked from, viewport and scissor dynamic so extent not part of it.
+		// views render passes created alike, so formats and sample count define render pass compatibility
+		struct pipeline_key
+		{
+			vk::Format _colorFormat{};
+			vk::Format _depthFormat{};
+			vk::SampleCountFlagBits _sampleCount{};
+			vk::PolygonMode _polygonMode{};
+
+			static pipeline_key makeFromView(const view& v);
+
+			bool operator==(const pipeline_key&) const = default;
+
+			struct hash
+			{
+				size_t operator()(const pipeline_key& key) const;
+			};
+		};
+
+		// pipeline shared by every view with the same key, null while its task compiles it
+		struct shared_pipeline
+		{
+			vk::UniquePipeline _pipeline;
+			std::shared_ptr<async_create_pipeline> _task;
+			uint32_t _viewCount{};
+		};
+
+		// unordered map never moves its elements, so shared one referenced directly
+		struct view_pipeline
+		{
+			pipeline_key _key;
+			const shared_pipeline* _shared{};
+		};
+
+		// pipeline of view key, creation queued to pipeline workers if no other view shares it yet
+		const shared_pipeline* acquirePipeline(const pipeline_key& key);
+
+		// destroyed once last view using it released it and frames drawn with it done
+		void releasePipeline(const pipeline_key& key);
+
+		std::shared_ptr<async_create_pipeline> createPipeline(const pipeline_key& key);
+
+		// called on main thread by pipeline workers pool tick
+		void onPipelineCreated(const pipeline_key& key, async_create_pipeline* task);
 
 		shader::shared _vert{};
 		shader::shared _frag{};
 
 		std::vector<vk::DescriptorSetLayout> _descriptorSetLayouts{};
-		vk::DescriptorPool _descriptorPool{};
 
-		uint32_t _depscriptorPoolMaxSets{};
+		// sets never freed one by one, so allocation from pool is linear and pool reset once all its instances released
+		struct descriptor_pool
+		{
+			vk::DescriptorPool _pool;
+			uint32_t _allocated{};
+			uint32_t _live{};
+		};
+		std::vector<descriptor_pool> _descriptorPools{};
+		uint32_t _currentDescriptorPool{};
+		uint32_t _instancesPerDescriptorPool{};
+
+		// layouts of sets every instance owns and pool sizes of single instance
+		std::vector<vk::DescriptorSetLayout> _instanceSetLayouts{};
+		std::vector<vk::DescriptorPoolSize> _instancePoolSizes{};
+
+		std::vector<descriptor_binding_slot> _bindingSlots{};
+		uint32_t _instanceDescriptorCount{};
+		std::vector<vk::DescriptorUpdateTemplate> _descriptorUpdateTemplates{};
+
+		std::vector<vk::DeviceSize> _dynamicStrides{};
+		std::vector<uint32_t> _dynamicCounts{};
+
+		// indexed by set number, null for sets allocated for every instance
+		std::vector<vk::DescriptorSet> _globalDescriptorSets{};
 
 		vk::PipelineLayout _pipelineLayout{};
-		std::map<uint32_t, vk::UniquePipeline> _pipelines{};
+		std::unordered_map<pipeline_key, shared_pipeline, pipeline_key::hash> _pipelines{};
+		std::map<uint32_t, view_pipeline> _viewPipelines{};
+
+		// tasks not completed yet, including ones of released pipelines
+		std::vector<std::shared_ptr<async_create_pipeline>> _pendingPipelines{};
 
 		std::vector<material_instance::unique> _instances{};
 
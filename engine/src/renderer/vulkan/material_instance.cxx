@@ -1,26 +1,52 @@
 #include "material_instance.hxx"
 
+#include "dreco.hxx"
 #include "renderer.hxx"
 
+#include <array>
+#include <cassert>
+
 de::vulkan::material_instance::material_instance(material* owner)
 {
 	_owner = owner;
+	_descriptorSets = _owner->getGlobalDescriptorSets();
+
+	const auto& placeholder = renderer::get()->getTextureImagePlaceholder();
+	_descriptors.resize(_owner->getInstanceDescriptorCount());
+	for (const auto& slot : _owner->getBindingSlots())
+	{
+		if (slot._type != vk::DescriptorType::eCombinedImageSampler)
+			continue;
+
+		for (uint32_t i = 0; i < slot._count; ++i)
+		{
+			_descriptors[slot._firstDescriptor + i]._image = vk::DescriptorImageInfo(placeholder.getSampler(), placeholder.getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+		}
+	}
+
 	allocate();
 }
 
 void de::vulkan::material_instance::allocate()
 {
-	auto device = renderer::get()->getDevice();
-	_descriptorSets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
-														.setDescriptorPool(_owner->getDescriptorPool())
-														.setSetLayouts(_owner->getDescriptorSetLayouts()));
+	std::array<vk::DescriptorSet, 8> ownedSets{};
+	assert(_descriptorSets.size() <= ownedSets.size());
+	_owner->allocateDescriptorSets(_descriptorPoolIndex, ownedSets.data());
+
+	for (uint32_t i = 0, k = 0; i < _descriptorSets.size(); ++i)
+	{
+		if (!_owner->isGlobalDescriptorSet(i))
+			_descriptorSets[i] = ownedSets[k++];
+	}
 }
 
-void de::vulkan::material_instance::free()
+void de::vulkan::material_instance::retire()
 {
-	auto device = renderer::get()->getDevice();
-	device.freeDescriptorSets(_owner->getDescriptorPool(), _descriptorSets);
-	_descriptorSets.clear();
+	// materials destroyed only after every deferred destroy run
+	renderer::get()->deferDestroy([owner = _owner, poolIndex = _descriptorPoolIndex]()
+		{ owner->releaseDescriptorSets(poolIndex); });
+	_descriptorPoolIndex = UINT32_MAX;
+	_bound = false;
 }
 
 de::vulkan::material* de::vulkan::material_instance::getMaterial() const
@@ -28,112 +54,113 @@ de::vulkan::material* de::vulkan::material_instance::getMaterial() const
 	return _owner;
 }
 
-void de::vulkan::material_instance::updateShaderDescriptors(const shader& inShader)
+uint32_t de::vulkan::material_instance::getBindingSlot(std::string_view inName) const
 {
-	std::vector<vk::WriteDescriptorSet> writes;
+	const auto& slots = _owner->getBindingSlots();
+	for (uint32_t i = 0; i < slots.size(); ++i)
+	{
+		if (slots[i]._name == inName)
+			return i;
+	}
+	return UINT32_MAX;
+}
 
-	const auto descriptorBufferInfos = getDescriptorBufferInfos(inShader);
-	const auto descriptorImageInfos = getDescriptorImageInfos(inShader);
+void de::vulkan::material_instance::setBufferDependency(std::string_view inName, const de::vulkan::buffer_view* inBuffer, uint32_t arrayIndex)
+{
+	setBufferDependency(getBindingSlot(inName), inBuffer, arrayIndex);
+}
 
-	const auto& relf = inShader.getRefl();
-	for (uint8_t i = 0; i < relf.descriptor_set_count; i++)
+void de::vulkan::material_instance::setBufferDependency(uint32_t slot, const de::vulkan::buffer_view* inBuffer, uint32_t arrayIndex)
+{
+	const auto& slots = _owner->getBindingSlots();
+	if (slot >= slots.size() || arrayIndex >= slots[slot]._count)
 	{
-		const auto& reflDescSet = relf.descriptor_sets[i];
-		for (uint8_t k = 0; k < reflDescSet.binding_count; k++)
-		{
-			const auto& reflBinding = relf.descriptor_bindings[k];
-
-			vk::WriteDescriptorSet& write = writes.emplace_back(vk::WriteDescriptorSet())
-												.setDstSet(_descriptorSets[reflDescSet.set])
-												.setDstBinding(reflBinding.binding)
-												.setDescriptorCount(reflBinding.count)
-												.setDescriptorType(static_cast<vk::DescriptorType>(reflBinding.descriptor_type));
-			switch (write.descriptorType)
-			{
-			case vk::DescriptorType::eUniformBuffer:
-				write.setPBufferInfo(descriptorBufferInfos.at(reflBinding.name).data());
-				break;
-			case vk::DescriptorType::eCombinedImageSampler:
-				write.setPImageInfo(descriptorImageInfos.at(reflBinding.name).data());
-				break;
-			default:
-				break;
-			}
-		}
+		DE_LOG(Error, "%s: No binding slot %u with element %u", __FUNCTION__, slot, arrayIndex);
+		return;
 	}
-	renderer::get()->getDevice().updateDescriptorSets(writes, {});
+
+	const auto& bindingSlot = slots[slot];
+	_descriptors[bindingSlot._firstDescriptor + arrayIndex]._buffer = vk::DescriptorBufferInfo()
+																		  .setBuffer(inBuffer->get())
+																		  .setOffset(inBuffer->getOffset())
+																		  .setRange(bindingSlot._range != VK_WHOLE_SIZE ? bindingSlot._range : inBuffer->getSize());
 }
 
-std::map<std::string, std::vector<vk::DescriptorBufferInfo>> de::vulkan::material_instance::getDescriptorBufferInfos(const shader& inShader) const
+void de::vulkan::material_instance::setImageDependecy(std::string_view inName, const image* inImage, uint32_t arrayIndex)
 {
-	std::map<std::string, std::vector<vk::DescriptorBufferInfo>> out;
-
-	const auto& relf = inShader.getRefl();
+	setImageDependecy(getBindingSlot(inName), inImage, arrayIndex);
+}
 
-	for (uint8_t i = 0; i < relf.descriptor_binding_count; i++)
+void de::vulkan::material_instance::setImageDependecy(uint32_t slot, const image* inImage, uint32_t arrayIndex)
+{
+	const auto& slots = _owner->getBindingSlots();
+	if (slot >= slots.size() || arrayIndex >= slots[slot]._count)
 	{
-		const auto& reflBinding = relf.descriptor_bindings[i];
-		if (reflBinding.descriptor_type != SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-		{
-			continue;
-		}
+		DE_LOG(Error, "%s: No binding slot %u with element %u", __FUNCTION__, slot, arrayIndex);
+		return;
+	}
 
-		const auto descBufferInfo = out.emplace(reflBinding.name, std::vector<vk::DescriptorBufferInfo>());
-		descBufferInfo.first->second.reserve(reflBinding.count);
+	_descriptors[slots[slot]._firstDescriptor + arrayIndex]._image = vk::DescriptorImageInfo()
+																		 .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+																		 .setImageView(inImage->getImageView())
+																		 .setSampler(inImage->getSampler());
+}
+
+void de::vulkan::material_instance::updateDescriptorSets()
+{
+	if (_bound)
+	{
+		retire();
+		allocate();
+	}
 
-		const auto& bufferBind = _buffers.at(reflBinding.name);
-		for (uint32_t k = 0; k < reflBinding.count; ++k)
+	// template offsets relative to start of descriptors array of instance
+	const auto device = renderer::get()->getDevice();
+	for (uint32_t i = 0; i < _descriptorSets.size(); ++i)
+	{
+		if (const auto updateTemplate = _owner->getDescriptorUpdateTemplate(i))
 		{
-			const auto buffer = bufferBind[k];
-			auto info = vk::DescriptorBufferInfo()
-							.setBuffer(buffer->get())
-							.setOffset(0)
-							.setRange(buffer->getSize());
-			descBufferInfo.first->second.push_back(info);
+			device.updateDescriptorSetWithTemplate(_descriptorSets[i], updateTemplate, _descriptors.data());
 		}
 	}
-
-	return out;
 }
 
-std::map<std::string, std::vector<vk::DescriptorImageInfo>> de::vulkan::material_instance::getDescriptorImageInfos(const shader& inShader) const
+void de::vulkan::material_instance::bindCmd(vk::CommandBuffer commandBuffer) const
 {
-	std::map<std::string, std::vector<vk::DescriptorImageInfo>> out;
+	const uint32_t sliceIndex = renderer::get()->getFrameSliceIndex();
+	const auto& dynamicStrides = _owner->getDynamicStrides();
+	const auto& dynamicCounts = _owner->getDynamicCounts();
 
-	const auto& relf = inShader.getRefl();
+	std::array<uint32_t, 8> dynamicOffsets{};
+	assert(dynamicStrides.size() <= dynamicOffsets.size());
+	for (size_t i = 0; i < dynamicStrides.size(); ++i)
+	{
+		dynamicOffsets[i] = static_cast<uint32_t>(sliceIndex * dynamicStrides[i]);
+	}
 
-	for (uint8_t i = 0; i < relf.descriptor_binding_count; i++)
+	// runs of owned sets, global ones left as material bound them
+	uint32_t dynamicOffsetIndex = 0;
+	for (uint32_t first = 0; first < _descriptorSets.size();)
 	{
-		const auto& reflBinding = relf.descriptor_bindings[i];
-		if (reflBinding.descriptor_type != SPV_REFLECT_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+		if (_owner->isGlobalDescriptorSet(first))
 		{
+			++first;
 			continue;
 		}
 
-		const auto descBufferInfo = out.emplace(reflBinding.name, std::vector<vk::DescriptorImageInfo>());
-		descBufferInfo.first->second.reserve(reflBinding.count);
-
-		const auto& bindIt = _images.find(reflBinding.name);
-		for (uint32_t k = 0; k < reflBinding.count; ++k)
+		uint32_t count = 0;
+		uint32_t dynamicCount = 0;
+		while (first + count < _descriptorSets.size() && !_owner->isGlobalDescriptorSet(first + count))
 		{
-			const auto image = bindIt != _images.end() ? bindIt->second[k] : &renderer::get()->getTextureImagePlaceholder();
-			auto info = vk::DescriptorImageInfo()
-							.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-							.setImageView(image->getImageView())
-							.setSampler(image->getSampler());
-			descBufferInfo.first->second.push_back(info);
+			dynamicCount += dynamicCounts[first + count];
+			++count;
 		}
-	}
-	return out;
-}
-
-void de::vulkan::material_instance::updateDescriptorSets()
-{
-	updateShaderDescriptors(*_owner->getVertShader());
-	updateShaderDescriptors(*_owner->getFragShader());
-}
 
-void de::vulkan::material_instance::bindCmd(vk::CommandBuffer commandBuffer) const
-{
-	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _owner->getPipelineLayout(), 0, _descriptorSets, nullptr);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _owner->getPipelineLayout(), first,
+			vk::ArrayProxy<const vk::DescriptorSet>(count, _descriptorSets.data() + first),
+			vk::ArrayProxy<const uint32_t>(dynamicCount, dynamicOffsets.data() + dynamicOffsetIndex));
+		dynamicOffsetIndex += dynamicCount;
+		first += count;
+	}
+	_bound = true;
 }
\ No newline at end of file
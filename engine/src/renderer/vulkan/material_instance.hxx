@@ -4,22 +4,53 @@
 #include "image.hxx"
 #include "shader.hxx"
 
-#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
 namespace de::vulkan
 {
 	class material;
+
+	// reflected binding of set instances own, descriptors of all of them stored in one flat array of instance
+	struct descriptor_binding_slot
+	{
+		std::string _name;
+		uint32_t _set{};
+		uint32_t _binding{};
+		uint32_t _count{};
+		vk::DescriptorType _type{};
+
+		// dynamic binding sees single slice of that size
+		vk::DeviceSize _range{VK_WHOLE_SIZE};
+
+		// index of first descriptor of binding in instance array
+		uint32_t _firstDescriptor{};
+	};
+
+	// element of instance array, update template reads info of binding type from it
+	union descriptor_info
+	{
+		descriptor_info()
+			: _buffer{}
+		{
+		}
+
+		vk::DescriptorBufferInfo _buffer;
+		vk::DescriptorImageInfo _image;
+	};
+
 	class material_instance final
 	{
 		friend material;
 		material_instance(material* owner);
 
 		void allocate();
-		void free();
+
+		// free sets once frames in flight that may use them done
+		void retire();
 
 	public:
 		using unique = std::unique_ptr<material_instance>;
@@ -30,66 +61,34 @@ namespace de::vulkan
 
 		material* getMaterial() const;
 
-		template <typename Str>
-		void setBufferDependency(Str&& inName, const de::vulkan::buffer* inBuffer, size_t arrayIndex = 0);
-
-		template <typename Str>
-		void setBufferDependencySize(Str&& inName, size_t size);
+		// slot of binding with that name, UINT32_MAX if shaders have none. Cache it to skip lookup by name
+		uint32_t getBindingSlot(std::string_view inName) const;
 
-		template <typename Str>
-		void setImageDependecy(Str&& inName, const image* inImage, size_t arrayIndex = 0);
+		void setBufferDependency(std::string_view inName, const de::vulkan::buffer_view* inBuffer, uint32_t arrayIndex = 0);
+		void setBufferDependency(uint32_t slot, const de::vulkan::buffer_view* inBuffer, uint32_t arrayIndex = 0);
 
-		template <typename Str>
-		void setImageDependecySize(Str&& inName, size_t size);
+		// images not set sample renderer placeholder
+		void setImageDependecy(std::string_view inName, const image* inImage, uint32_t arrayIndex = 0);
+		void setImageDependecy(uint32_t slot, const image* inImage, uint32_t arrayIndex = 0);
 
+		// every owned set written with update template of material from flat descriptor array.
+		// sets already bound to command buffer are not updated in place, new ones allocated instead
 		void updateDescriptorSets();
 
+		// owned sets only, material binds global ones. Dynamic offsets select slice of current view frame
 		void bindCmd(vk::CommandBuffer commandBuffer) const;
 
 	private:
-		void updateShaderDescriptors(const shader& inShader);
-		std::map<std::string, std::vector<vk::DescriptorBufferInfo>> getDescriptorBufferInfos(const shader& inShader) const;
-		std::map<std::string, std::vector<vk::DescriptorImageInfo>> getDescriptorImageInfos(const shader& inShader) const;
-
 		material* _owner{};
 
+		// indexed by set number, global ones filled with sets of renderer
 		std::vector<vk::DescriptorSet> _descriptorSets{};
 
-		std::map<std::string, std::vector<const de::vulkan::buffer*>> _buffers{};
-		std::map<std::string, std::vector<const image*>> _images{};
-	};
-
-	template <typename Str>
-	void material_instance::setBufferDependency(Str&& inName, const de::vulkan::buffer* inBuffer, size_t arrayIndex)
-	{
-		auto it = _buffers.try_emplace(std::forward<Str>(inName), std::vector<const de::vulkan::buffer*>(1, nullptr));
-		it.first->second[arrayIndex] = inBuffer;
-	}
+		// pool of material chain owned sets allocated from
+		uint32_t _descriptorPoolIndex{UINT32_MAX};
 
-	template <typename Str>
-	void material_instance::setBufferDependencySize(Str&& inName, size_t size)
-	{
-		auto& arr = _buffers[std::forward<Str>(inName)];
-		if (arr.size() != size)
-		{
-			arr.resize(size);
-		}
-	}
+		mutable bool _bound{false};
 
-	template <typename Str>
-	void material_instance::setImageDependecy(Str&& inName, const image* inImage, size_t arrayIndex)
-	{
-		auto it = _images.try_emplace(std::forward<Str>(inName), std::vector<const image*>(1, nullptr));
-		it.first->second[arrayIndex] = inImage;
-	}
-
-	template <typename Str>
-	void material_instance::setImageDependecySize(Str&& inName, size_t size)
-	{
-		auto& arr = _images[std::forward<Str>(inName)];
-		if (arr.size() != size)
-		{
-			arr.resize(size);
-		}
-	}
+		std::vector<descriptor_info> _descriptors{};
+	};
 } // namespace de::vulkan
\ No newline at end of file
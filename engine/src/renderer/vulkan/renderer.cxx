@@ -1,8 +1,10 @@
 #include "renderer.hxx"
 
 #include "core/engine.hxx"
+#include "core/misc/file.hxx"
 #include "game_framework/camera.hxx"
 #include "math/casts.hxx"
+#include "math/frustum.hxx"
 
 #include "constants.hxx"
 #include "dreco.hxx"
@@ -10,7 +12,10 @@
 
 #include <SDL_video.h>
 #include <SDL_vulkan.h>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
 
 de::vulkan::renderer::~renderer()
 {
@@ -59,14 +64,30 @@ void de::vulkan::renderer::init()
 		}
 
 		createDevice();
+		createPipelineCache();
 
 		createQueues();
 		createBufferPools();
 		createCommandPools();
+
+		_uploader.init(64 * 1024 * 1024);
+
+		// calling thread records one job as well
+		_recordJobCount = std::clamp(de::async::thread_pool::hardwareConcurrency(), 1U, maxRecordJobs);
+		_recordThreadPool.allocateThreads("dreco-render-worker", _recordJobCount - 1, de::async::thread_pool::priority::high);
+
+		// driver compiles pipelines of different keys in parallel
+		_pipelineThreadPool.allocateThreads("dreco-pipeline-worker", std::max(de::async::thread_pool::hardwareConcurrency(), 2U) - 1);
 	}
 
 	{ // common renderer resources
 		createCameraBuffer();
+		createFrameDescriptorSet();
+		_culling.init();
+
+		// before any texture so placeholder takes first slot
+		_bindlessHeap.init();
+		createGlobalPipelineLayout();
 		_placeholderTextureImage.create(de::gltf::image::makePlaceholder(256, 256));
 
 		{
@@ -95,20 +116,57 @@ void de::vulkan::renderer::exit()
 
 	_device.waitIdle();
 
+	_recordThreadPool.freeThreads();
+	_pipelineThreadPool.freeThreads();
+
+	runDeferredDestroys(true);
+
+	_uploader.destroy();
+
 	_skybox.destroy();
 	_placeholderTextureImage.destroy();
 
 	_scenes.clear();
+
+	// scenes defer free of their culling sets and pool buffers
+	runDeferredDestroys(true);
+	_culling.destroy();
+
 	_shaders.clear();
 	_materials.clear();
+
+	// textures and materials using heap destroyed, defer release of its slots
+	runDeferredDestroys(true);
+	_device.destroyPipelineLayout(_globalPipelineLayout);
+	_bindlessHeap.destroy();
+
+	_device.destroyDescriptorPool(_frameDescriptorPool);
+	_device.destroyDescriptorSetLayout(_frameDescriptorSetLayout);
 	_views = {};
 
+	savePipelineCache();
+	_device.destroyPipelineCache(_pipelineCache);
+
 	_device.destroyCommandPool(_graphicsCommandPool);
-	_device.destroyCommandPool(_transferCommandPool);
+
+	const auto logPoolStats = [](const char* name, const buffer_pool& pool)
+	{
+		const auto stats = pool.getStats();
+		DE_LOG(Info, "Buffer pool %s: size %llu KB, peak used %llu KB, high-water %llu KB, fragmentation %.2f", name,
+			static_cast<unsigned long long>(stats._size / 1024), static_cast<unsigned long long>(stats._peakUsedSize / 1024),
+			static_cast<unsigned long long>(stats._highWaterMark / 1024), stats.getFragmentation());
+	};
+	logPoolStats("vertex/index", _bpVertIndx);
+	logPoolStats("uniform", _bpUniforms);
+	logPoolStats("transfer", _bpTransfer);
+	logPoolStats("frame uniforms", _bpFrameUniforms);
+	logPoolStats("indirect", _bpIndirect);
 
 	_bpVertIndx.destroy();
 	_bpUniforms.destroy();
 	_bpTransfer.destroy();
+	_bpFrameUniforms.destroy();
+	_bpIndirect.destroy();
 	_device.destroy();
 
 	_instance.destroy();
@@ -118,6 +176,30 @@ void de::vulkan::renderer::exit()
 
 void de::vulkan::renderer::tick(double deltaTime)
 {
+	++_frameNumber;
+
+	if (_frameDrawStats != _drawStats)
+	{
+		DE_LOG(Verbose, "%s: %u draws, binds per frame requested %u, recorded %u (pipelines %u, descriptor sets %u, geometry %u)", __FUNCTION__,
+			_frameDrawStats._draws, _frameDrawStats._requestedBinds, _frameDrawStats.getRecordedBinds(),
+			_frameDrawStats._pipelineBinds, _frameDrawStats._descriptorSetBinds, _frameDrawStats._geometryBinds);
+	}
+	_drawStats = _frameDrawStats;
+	_frameDrawStats = draw_stats();
+
+	// submit uploads recorded since last tick and release finished ones
+	_uploader.tick();
+
+	runDeferredDestroys(false);
+
+	// starts pipeline tasks queued since last tick, hands created pipelines to materials
+	_pipelineThreadPool.tick(_frameNumber);
+
+	for (auto& scene : _scenes)
+	{
+		scene->tick();
+	}
+
 	for (size_t i = 0; i < _views.size(); ++i)
 	{
 		auto& currentView = _views[i];
@@ -130,7 +212,7 @@ void de::vulkan::renderer::tick(double deltaTime)
 		{
 			currentView->recreateSwapchain();
 
-			// update all materials after swapchain recreation
+			// materials rebuild pipelines only if state they baked from changed, extent is dynamic
 			for (auto& mat : _materials)
 			{
 				mat.second->viewUpdated(_currentDrawViewIndex);
@@ -148,14 +230,26 @@ void de::vulkan::renderer::tick(double deltaTime)
 		_cameraData.proj = de::math::mat4::makeProjection(0.1f, 1000.f, static_cast<float>(viewExtent.width) / static_cast<float>(viewExtent.height), de::math::deg_to_rad(75.F));
 		updateCameraBuffer();
 
-		auto commandBuffer = currentView->beginCommandBuffer(nextImage);
-
-		_skybox.drawCmd(commandBuffer);
-
+		const auto viewProj = _cameraData.view * _cameraData.proj;
+		const auto frustum = de::math::frustum::makeFromViewProjection(viewProj);
 		for (auto& scene : _scenes)
 		{
-			scene->bindToCmdBuffer(commandBuffer);
+			scene->cullMeshes(frustum);
 		}
+		_drawList.build(_currentDrawViewIndex, _scenes, frustum);
+
+		auto commandBuffer = currentView->beginCommandBuffer();
+
+		_culling.cullCmd(commandBuffer, *currentView, viewProj);
+
+		currentView->beginRenderPass(commandBuffer, nextImage);
+
+		recordDrawCommands(*currentView, commandBuffer, nextImage);
+
+		currentView->endRenderPass(commandBuffer);
+
+		_culling.buildHiZCmd(commandBuffer, *currentView);
+
 		currentView->endCommandBuffer(commandBuffer);
 
 		currentView->submitCommandBuffer(nextImage, commandBuffer);
@@ -214,9 +308,11 @@ de::vulkan::material* de::vulkan::renderer::getMaterial(const std::string_view&
 	return nullptr;
 }
 
-void de::vulkan::renderer::loadModel(const de::gltf::model& scn)
+de::vulkan::scene* de::vulkan::renderer::loadModel(const de::gltf::model& scn)
 {
-	_scenes.emplace_back(new scene())->create(scn);
+	auto& newScene = _scenes.emplace_back(new scene());
+	newScene->create(scn);
+	return newScene.get();
 }
 
 de::vulkan::shader::shared de::vulkan::renderer::loadShader(const std::string_view& path)
@@ -241,27 +337,110 @@ uint32_t de::vulkan::renderer::getVersion(uint32_t& major, uint32_t& minor, uint
 	return _apiVersion;
 }
 
-vk::SharingMode de::vulkan::renderer::getSharingMode() const
+void de::vulkan::renderer::recordDrawCommands(view& currentView, vk::CommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	// sorted draws split to contiguous ranges, so execution order same as single threaded recording
+	const size_t totalDraws = _drawList.size();
+
+	// too small jobs cost more to begin and execute than they save
+	constexpr size_t minDrawsPerJob = 16;
+	const uint32_t jobCount = static_cast<uint32_t>(std::clamp<size_t>((totalDraws + minDrawsPerJob - 1) / minDrawsPerJob, 1, _recordJobCount));
+	const size_t drawsPerJob = (totalDraws + jobCount - 1) / jobCount;
+
+	std::array<vk::CommandBuffer, maxRecordJobs> secondaryCommandBuffers{};
+	std::array<draw_stats, maxRecordJobs> jobStats{};
+	_recordThreadPool.parallelFor(jobCount, [&](uint32_t job)
+		{
+			auto secondary = currentView.beginSecondaryCommandBuffer(job, imageIndex);
+
+			// secondary command buffer starts with nothing bound
+			bindGlobalDescriptorSets(secondary);
+			jobStats[job]._descriptorSetBinds += constants::descriptors::globalSetCount;
+
+			if (job == 0)
+			{
+				_skybox.drawCmd(secondary);
+			}
+
+			_drawList.record(secondary, job * drawsPerJob, drawsPerJob, jobStats[job]);
+
+			secondary.end();
+			secondaryCommandBuffers[job] = secondary;
+		});
+
+	commandBuffer.executeCommands(jobCount, secondaryCommandBuffers.data());
+
+	for (uint32_t i = 0; i < jobCount; ++i)
+	{
+		_frameDrawStats += jobStats[i];
+	}
+}
+
+void de::vulkan::renderer::bindGeometry(vk::CommandBuffer commandBuffer) const
 {
-	return vk::SharingMode::eExclusive;
+	const vk::Buffer buffer = _bpVertIndx.get();
+
+	commandBuffer.bindVertexBuffers(0, buffer, {vk::DeviceSize{0}});
+	commandBuffer.bindIndexBuffer(buffer, 0, vk::IndexType::eUint32);
 }
 
-std::vector<uint32_t> de::vulkan::renderer::getQueueFamilyIndices() const
+void de::vulkan::renderer::bindGlobalDescriptorSets(vk::CommandBuffer commandBuffer) const
 {
-	if (_graphicsQueueIndex == _transferQueueIndex)
+	const std::array<vk::DescriptorSet, constants::descriptors::globalSetCount> sets{_frameDescriptorSet, _bindlessHeap.getSet()};
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _globalPipelineLayout, constants::descriptors::frameSet, sets, getFrameDescriptorSetOffset());
+}
+
+void de::vulkan::renderer::deferDestroy(std::function<void()>&& destroyFunc)
+{
+	_deferredDestroys.push_back(deferred_destroy{._frameNumber = _frameNumber, ._destroyFunc = std::move(destroyFunc)});
+}
+
+void de::vulkan::renderer::runDeferredDestroys(bool all)
+{
+	uint64_t completedFrameNumber = _frameNumber;
+	if (!all)
 	{
-		return std::vector<uint32_t>{_graphicsQueueIndex};
+		for (const auto& view : _views)
+		{
+			if (view != nullptr && view->isInitialized())
+			{
+				completedFrameNumber = std::min(completedFrameNumber, view->getCompletedFrameNumber());
+			}
+		}
 	}
-	return std::vector<uint32_t>{_graphicsQueueIndex, _transferQueueIndex};
+
+	// queue ordered by frame number, so destroys done in order they were deferred
+	while (!_deferredDestroys.empty() && (all || _deferredDestroys.front()._frameNumber <= completedFrameNumber))
+	{
+		auto destroyFunc = std::move(_deferredDestroys.front()._destroyFunc);
+		_deferredDestroys.pop_front();
+		destroyFunc();
+	}
+}
+
+uint32_t de::vulkan::renderer::getFrameSliceCount() const
+{
+	return static_cast<uint32_t>(_views.size()) * constants::frames::maxInFlight;
+}
+
+uint32_t de::vulkan::renderer::getFrameSliceIndex() const
+{
+	return _currentDrawViewIndex * constants::frames::maxInFlight + getView(_currentDrawViewIndex)->getFrameIndex();
+}
+
+vk::DeviceSize de::vulkan::renderer::getFrameSliceStride(vk::DeviceSize size) const
+{
+	const vk::DeviceSize alignment = _physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment;
+	return (size + alignment - 1) / alignment * alignment;
 }
 
-vk::CommandBuffer de::vulkan::renderer::beginSingleTimeTransferCommands()
+vk::CommandBuffer de::vulkan::renderer::beginSingleTimeGraphicsCommands()
 {
 	const vk::CommandBufferAllocateInfo commandBufferAllocateInfo =
 		vk::CommandBufferAllocateInfo()
 			.setLevel(vk::CommandBufferLevel::ePrimary)
 			.setCommandBufferCount(1)
-			.setCommandPool(_transferCommandPool);
+			.setCommandPool(_graphicsCommandPool);
 
 	vk::CommandBuffer commandBuffer = _device.allocateCommandBuffers(commandBufferAllocateInfo)[0];
 
@@ -272,18 +451,13 @@ vk::CommandBuffer de::vulkan::renderer::beginSingleTimeTransferCommands()
 	return commandBuffer;
 }
 
-void de::vulkan::renderer::submitSingleTimeTransferCommands(vk::CommandBuffer commandBuffer)
+void de::vulkan::renderer::submitSingleTimeGraphicsCommands(vk::CommandBuffer commandBuffer)
 {
 	const vk::SubmitInfo submitInfo =
 		vk::SubmitInfo().setCommandBuffers({1, &commandBuffer});
 
-	submitSingleTimeTransferCommands({submitInfo});
-}
-
-void de::vulkan::renderer::submitSingleTimeTransferCommands(const std::vector<vk::SubmitInfo>& submits)
-{
-	_transferQueue.submit(submits, nullptr);
-	_transferQueue.waitIdle();
+	_graphicsQueue.submit(submitInfo, nullptr);
+	_graphicsQueue.waitIdle();
 }
 
 void de::vulkan::renderer::createInstance()
@@ -361,7 +535,7 @@ void de::vulkan::renderer::createDevice()
 			.setQueuePriorities(priorities);
 	}
 
-	const std::vector<const char*> enabledExtensions{"VK_KHR_swapchain"};
+	std::vector<const char*> enabledExtensions{"VK_KHR_swapchain"};
 	const std::vector<const char*> enabledLayers{
 #ifdef DRECO_VK_USE_MESA_OVERLAY
 		"VK_LAYER_MESA_overlay",
@@ -372,9 +546,75 @@ void de::vulkan::renderer::createDevice()
 	};
 
 	const vk::PhysicalDeviceFeatures physicalDeviceFeatures = _physicalDevice.getFeatures();
+	_multiDrawIndirect = physicalDeviceFeatures.multiDrawIndirect;
+
+	// materials sample textures from bindless heap by index, descriptor indexing of 1.2 or its extension on 1.1 required.
+	// core and extension feature structs share member names
+	const auto isDescriptorIndexingSupported = [](const auto& supported)
+	{
+		return supported.runtimeDescriptorArray && supported.shaderSampledImageArrayNonUniformIndexing && supported.descriptorBindingPartiallyBound &&
+			   supported.descriptorBindingSampledImageUpdateAfterBind && supported.descriptorBindingUpdateUnusedWhilePending;
+	};
+	const auto enableDescriptorIndexing = [](auto& enabled)
+	{
+		enabled.setRuntimeDescriptorArray(true)
+			.setShaderSampledImageArrayNonUniformIndexing(true)
+			.setDescriptorBindingPartiallyBound(true)
+			.setDescriptorBindingSampledImageUpdateAfterBind(true)
+			.setDescriptorBindingUpdateUnusedWhilePending(true);
+	};
+
+	vk::PhysicalDeviceVulkan12Features vulkan12Features;
+	vk::PhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures;
+	const void* enabledFeaturesChain{};
+	if (_apiVersion >= VK_API_VERSION_1_2)
+	{
+		const auto features = _physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		const auto& supported12Features = features.get<vk::PhysicalDeviceVulkan12Features>();
+		if (!isDescriptorIndexingSupported(supported12Features))
+		{
+			throw std::runtime_error("Descriptor indexing not supported, bindless textures unavailable");
+		}
+
+		_drawIndirectCount = supported12Features.drawIndirectCount;
+		vulkan12Features.setDrawIndirectCount(_drawIndirectCount);
+		enableDescriptorIndexing(vulkan12Features);
+		enabledFeaturesChain = &vulkan12Features;
+	}
+	else
+	{
+		// features2 query and maintenance3 the extension depends on are core from 1.1
+		if (_apiVersion < VK_API_VERSION_1_1)
+		{
+			throw std::runtime_error("Vulkan 1.1 required");
+		}
+
+		const auto extensions = _physicalDevice.enumerateDeviceExtensionProperties();
+		const bool hasExtension = std::any_of(extensions.begin(), extensions.end(), [](const vk::ExtensionProperties& extension)
+			{ return std::strcmp(extension.extensionName, "VK_EXT_descriptor_indexing") == 0; });
+		if (!hasExtension)
+		{
+			throw std::runtime_error("Vulkan 1.2 or VK_EXT_descriptor_indexing required for bindless textures");
+		}
+
+		const auto features = _physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+		if (!isDescriptorIndexingSupported(features.get<vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>()))
+		{
+			throw std::runtime_error("Descriptor indexing not supported, bindless textures unavailable");
+		}
+
+		DE_LOG(Info, "%s: Vulkan 1.1 device, VK_EXT_descriptor_indexing enabled for bindless textures", __FUNCTION__);
+		enabledExtensions.push_back("VK_EXT_descriptor_indexing");
+		enableDescriptorIndexing(descriptorIndexingFeatures);
+		enabledFeaturesChain = &descriptorIndexingFeatures;
+
+		// draw count is core only from 1.2, culled draws stay in place and are drawn without it
+		_drawIndirectCount = false;
+	}
 
 	const vk::DeviceCreateInfo deviceCreateInfo =
 		vk::DeviceCreateInfo()
+			.setPNext(enabledFeaturesChain)
 			.setQueueCreateInfos(queueCreateInfoList)
 			.setPEnabledLayerNames(enabledLayers)
 			.setPEnabledExtensionNames(enabledExtensions)
@@ -386,16 +626,40 @@ void de::vulkan::renderer::createDevice()
 void de::vulkan::renderer::createQueues()
 {
 	const auto queueFamilyProperties = _physicalDevice.getQueueFamilyProperties();
-	const size_t queueFamilyPropertiesSize = queueFamilyProperties.size();
-	for (size_t i = 0; i < queueFamilyPropertiesSize; ++i)
+	const uint32_t queueFamilyPropertiesSize = queueFamilyProperties.size();
+
+	_graphicsQueueIndex = UINT32_MAX;
+	for (uint32_t i = 0; i < queueFamilyPropertiesSize; ++i)
 	{
-		const auto queueFlags = queueFamilyProperties[i].queueFlags;
-		if ((queueFlags & vk::QueueFlagBits::eGraphics) && (queueFlags & vk::QueueFlagBits::eTransfer))
+		if (queueFamilyProperties[i].queueFlags & vk::QueueFlagBits::eGraphics)
 		{
 			_graphicsQueueIndex = i;
+			break;
+		}
+	}
+	if (_graphicsQueueIndex == UINT32_MAX)
+	{
+		throw std::runtime_error("No graphics queue family");
+	}
+
+	// prefer transfer only family (dma engine), then any other family without graphics, graphics family otherwise
+	_transferQueueIndex = _graphicsQueueIndex;
+	uint32_t bestScore = 0;
+	for (uint32_t i = 0; i < queueFamilyPropertiesSize; ++i)
+	{
+		const auto queueFlags = queueFamilyProperties[i].queueFlags;
+		if (!(queueFlags & vk::QueueFlagBits::eTransfer) || (queueFlags & vk::QueueFlagBits::eGraphics))
+			continue;
+
+		const uint32_t score = (queueFlags & vk::QueueFlagBits::eCompute) ? 1 : 2;
+		if (score > bestScore)
+		{
+			bestScore = score;
 			_transferQueueIndex = i;
 		}
 	}
+
+	DE_LOG(Info, "%s: graphics queue family %u, transfer queue family %u", __FUNCTION__, _graphicsQueueIndex, _transferQueueIndex);
 	_graphicsQueue = _device.getQueue(_graphicsQueueIndex, 0);
 	_transferQueue = _device.getQueue(_transferQueueIndex, 0);
 }
@@ -406,11 +670,6 @@ void de::vulkan::renderer::createCommandPools()
 															 .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
 															 .setQueueFamilyIndex(_graphicsQueueIndex);
 	_graphicsCommandPool = _device.createCommandPool(graphicsCreateInfo);
-
-	const vk::CommandPoolCreateInfo transferCreateInfo = vk::CommandPoolCreateInfo()
-															 .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient)
-															 .setQueueFamilyIndex(_transferQueueIndex);
-	_transferCommandPool = _device.createCommandPool(transferCreateInfo);
 }
 
 void de::vulkan::renderer::createBufferPools()
@@ -419,18 +678,158 @@ void de::vulkan::renderer::createBufferPools()
 	constexpr auto vertIndxSize = 256 * 1024 * 1024;
 	_bpVertIndx.allocate(utils::memory_property::device, vertIndxUsage, vertIndxSize);
 
-	constexpr auto uniformsUsage = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst;
+	constexpr auto uniformsUsage = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
 	constexpr auto uniformsSize = 64 * 1024 * 1024;
 	_bpUniforms.allocate(utils::memory_property::device, uniformsUsage, uniformsSize);
 
 	constexpr auto transferUsage = vk::BufferUsageFlagBits::eTransferSrc;
 	constexpr auto transferSize = 256 * 1024 * 1024;
 	_bpTransfer.allocate(utils::memory_property::host, transferUsage, transferSize);
+
+	constexpr auto frameUniformsUsage = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer;
+	constexpr auto frameUniformsSize = 4 * 1024 * 1024;
+	_bpFrameUniforms.allocate(utils::memory_property::host, frameUniformsUsage, frameUniformsSize);
+
+	constexpr auto indirectUsage = vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+	constexpr auto indirectSize = 16 * 1024 * 1024;
+	_bpIndirect.allocate(utils::memory_property::device, indirectUsage, indirectSize);
+}
+
+// prepended to saved cache data, vulkan validates its own header against device but not against driver version
+struct pipeline_cache_file_header
+{
+	static constexpr uint32_t magic = 0x44524350; // DRCP
+
+	uint32_t _magic{magic};
+	uint32_t _vendorId{};
+	uint32_t _deviceId{};
+	uint32_t _driverVersion{};
+	std::array<uint8_t, VK_UUID_SIZE> _pipelineCacheUUID{};
+	uint64_t _dataSize{};
+
+	static pipeline_cache_file_header make(const vk::PhysicalDeviceProperties& properties, size_t dataSize)
+	{
+		pipeline_cache_file_header out;
+		out._vendorId = properties.vendorID;
+		out._deviceId = properties.deviceID;
+		out._driverVersion = properties.driverVersion;
+		std::memcpy(out._pipelineCacheUUID.data(), properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+		out._dataSize = dataSize;
+		return out;
+	}
+
+	bool operator==(const pipeline_cache_file_header&) const = default;
+};
+
+void de::vulkan::renderer::createPipelineCache()
+{
+	const std::string path = DRECO_SHADER(constants::pipelines::cacheFile);
+	const auto properties = _physicalDevice.getProperties();
+
+	std::string fileContent;
+	if (std::filesystem::is_regular_file(path))
+	{
+		fileContent = de::file::read(path);
+	}
+
+	auto createInfo = vk::PipelineCacheCreateInfo();
+	if (fileContent.size() >= sizeof(pipeline_cache_file_header))
+	{
+		pipeline_cache_file_header header;
+		std::memcpy(&header, fileContent.data(), sizeof(header));
+
+		const size_t dataSize = fileContent.size() - sizeof(header);
+		if (header == pipeline_cache_file_header::make(properties, dataSize))
+		{
+			createInfo.setInitialDataSize(dataSize).setPInitialData(fileContent.data() + sizeof(header));
+		}
+		else
+		{
+			DE_LOG(Info, "%s: pipeline cache saved by different device or driver, discarded", __FUNCTION__);
+		}
+	}
+
+	const auto result = _device.createPipelineCache(&createInfo, nullptr, &_pipelineCache);
+	if (result != vk::Result::eSuccess && createInfo.initialDataSize != 0)
+	{
+		DE_LOG(Error, "%s: failed to create pipeline cache from saved data, %s", __FUNCTION__, vk::to_string(result).c_str());
+		_pipelineCache = _device.createPipelineCache(vk::PipelineCacheCreateInfo());
+	}
+	else if (result != vk::Result::eSuccess)
+	{
+		DE_LOG(Error, "%s: failed to create pipeline cache, %s", __FUNCTION__, vk::to_string(result).c_str());
+	}
+	else
+	{
+		DE_LOG(Info, "%s: pipeline cache created with %llu bytes of saved data", __FUNCTION__, static_cast<unsigned long long>(createInfo.initialDataSize));
+	}
+}
+
+void de::vulkan::renderer::savePipelineCache()
+{
+	if (!_pipelineCache)
+	{
+		return;
+	}
+
+	const auto data = _device.getPipelineCacheData(_pipelineCache);
+	const auto header = pipeline_cache_file_header::make(_physicalDevice.getProperties(), data.size());
+
+	std::string fileContent(sizeof(header) + data.size(), '\0');
+	std::memcpy(fileContent.data(), &header, sizeof(header));
+	std::memcpy(fileContent.data() + sizeof(header), data.data(), data.size());
+	de::file::write(DRECO_SHADER(constants::pipelines::cacheFile), fileContent);
 }
 
 void de::vulkan::renderer::createCameraBuffer()
 {
-	_cameraDataBufferId = getUniformBufferPool().makeBuffer(sizeof(camera_data));
+	_cameraDataBufferId = getFrameUniformBufferPool().makeBuffer(getFrameSliceStride(sizeof(camera_data)) * getFrameSliceCount());
+}
+
+void de::vulkan::renderer::createFrameDescriptorSet()
+{
+	// shaders declare the same bindings in set 0, materials check reflected ones against it
+	const std::array<vk::DescriptorSetLayoutBinding, 1> bindings{
+		vk::DescriptorSetLayoutBinding()
+			.setBinding(0)
+			.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+			.setDescriptorCount(1)
+			.setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment)};
+	_frameDescriptorSetLayout = _device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo().setBindings(bindings));
+
+	const auto poolSize = vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, 1);
+	_frameDescriptorPool = _device.createDescriptorPool(vk::DescriptorPoolCreateInfo()
+															.setPoolSizes(poolSize)
+															.setMaxSets(1));
+
+	_frameDescriptorSet = _device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
+															 .setDescriptorPool(_frameDescriptorPool)
+															 .setSetLayouts(_frameDescriptorSetLayout))
+							  .front();
+
+	// dynamic binding sees single slice, camera buffer never reallocated so set written once
+	const auto& cameraBuffer = getCameraDataBuffer();
+	const auto bufferInfo = vk::DescriptorBufferInfo()
+								.setBuffer(cameraBuffer.get())
+								.setOffset(cameraBuffer.getOffset())
+								.setRange(sizeof(camera_data));
+	const auto write = vk::WriteDescriptorSet()
+						   .setDstSet(_frameDescriptorSet)
+						   .setDstBinding(0)
+						   .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+						   .setBufferInfo(bufferInfo);
+	_device.updateDescriptorSets(write, {});
+}
+
+void de::vulkan::renderer::createGlobalPipelineLayout()
+{
+	const std::array<vk::DescriptorSetLayout, constants::descriptors::globalSetCount> setLayouts{_frameDescriptorSetLayout, _bindlessHeap.getLayout()};
+	_globalPipelineLayout = _device.createPipelineLayout(vk::PipelineLayoutCreateInfo().setSetLayouts(setLayouts));
+}
+
+uint32_t de::vulkan::renderer::getFrameDescriptorSetOffset() const
+{
+	return static_cast<uint32_t>(getFrameSliceIndex() * getFrameSliceStride(sizeof(camera_data)));
 }
 
 void de::vulkan::renderer::setCameraView(uint32_t viewIndex, const de::math::mat4& inView)
@@ -440,14 +839,11 @@ void de::vulkan::renderer::setCameraView(uint32_t viewIndex, const de::math::mat
 
 void de::vulkan::renderer::updateCameraBuffer()
 {
-	constexpr auto size = sizeof(_cameraData);
-
-	static const auto id = _bpTransfer.makeBuffer(size);
-
-	auto region = _bpTransfer.map(id);
-	std::memcpy(region, &_cameraData, size);
-	_bpTransfer.unmap(id);
+	// slice of current view frame, previous reader of it is frame which fence already waited.
+	// host writes made visible by queue submit, so no copy or barrier recorded
+	const vk::DeviceSize sliceOffset = getFrameSliceIndex() * getFrameSliceStride(sizeof(_cameraData));
 
-	const auto copyRegion = vk::BufferCopy(0, 0, size);
-	de::vulkan::buffer::copyBuffer(_bpTransfer.getBuffer(id).get(), _bpUniforms.getBuffer(_cameraDataBufferId).get(), {copyRegion});
+	auto* mapped = reinterpret_cast<uint8_t*>(_bpFrameUniforms.map(_cameraDataBufferId));
+	memcpy(mapped + sliceOffset, &_cameraData, sizeof(_cameraData));
+	_bpFrameUniforms.flush(_cameraDataBufferId, sliceOffset, sizeof(_cameraData));
 }
\ No newline at end of file
@@ -5,14 +5,21 @@
 #include "images/msaa_image.hxx"
 #include "images/texture_image.hxx"
 #include "renderer/shader_types/camera_data.hxx"
+#include "threads/thread_pool.hxx"
 
+#include "bindless_heap.hxx"
 #include "buffer.hxx"
+#include "culling.hxx"
+#include "draw_list.hxx"
 #include "material.hxx"
 #include "scene.hxx"
 #include "settings.hxx"
 #include "skybox.hxx"
+#include "uploader.hxx"
 #include "view.hxx"
 
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <vector>
@@ -55,7 +62,7 @@ namespace de::vulkan
 
 		void setCameraView(uint32_t viewIndex, const de::math::mat4& inView);
 
-		void loadModel(const de::gltf::model& scn);
+		scene* loadModel(const de::gltf::model& scn);
 
 		shader::shared loadShader(const std::string_view& path);
 
@@ -63,19 +70,37 @@ namespace de::vulkan
 
 		uint32_t getImageCount() const;
 
-		vk::SharingMode getSharingMode() const;
-
-		std::vector<uint32_t> getQueueFamilyIndices() const;
-
 		std::array<view::unique, 16>& getViews() { return _views; }
 
 		view* getView(uint32_t index) const { return _views[index].get(); }
 
 		uint32_t getCurrentDrawViewIndex() const { return _currentDrawViewIndex; }
 
+		// incremented every tick, views tag submissions with it
+		uint64_t getFrameNumber() const { return _frameNumber; }
+
+		// call once every frame submitted so far done executing on gpu
+		void deferDestroy(std::function<void()>&& destroyFunc);
+
+		static constexpr uint32_t maxRecordJobs = 8;
+
+		// upper bound of secondary command buffers recorded in parallel per view frame
+		uint32_t getRecordJobCount() const { return _recordJobCount; }
+
+		// per frame buffers hold slice for every frame in flight of every view
+		uint32_t getFrameSliceCount() const;
+		uint32_t getFrameSliceIndex() const;
+		vk::DeviceSize getFrameSliceStride(vk::DeviceSize size) const;
+
 		vk::Queue getGraphicsQueue() const { return _graphicsQueue; }
 
-		vk::CommandPool getTransferCommandPool() const { return _transferCommandPool; }
+		uint32_t getGraphicsQueueIndex() const { return _graphicsQueueIndex; }
+
+		vk::Queue getTransferQueue() const { return _transferQueue; }
+
+		uint32_t getTransferQueueIndex() const { return _transferQueueIndex; }
+
+		vk::CommandPool getGraphicsCommandPool() const { return _graphicsCommandPool; }
 
 		vk::Instance getInstance() { return _instance; }
 
@@ -83,11 +108,21 @@ namespace de::vulkan
 
 		vk::Device getDevice() const { return _device; }
 
+		// shared by every pipeline creation, internally synchronized so threads create pipelines with it concurrently
+		vk::PipelineCache getPipelineCache() const { return _pipelineCache; }
+
+		// material pipelines compiled by its threads, completions handled on renderer tick
+		de::async::thread_pool& getPipelineThreadPool() { return _pipelineThreadPool; }
+
 		const std::vector<std::unique_ptr<scene>>& getScenes() const { return _scenes; }
 		std::vector<std::unique_ptr<scene>>& getScenes() { return _scenes; }
 
 		const texture_image& getTextureImagePlaceholder() const { return _placeholderTextureImage; }
 
+		// every texture image registered, materials bind its set in place of per material texture descriptors
+		bindless_heap& getBindlessHeap() { return _bindlessHeap; }
+
+		// vertex and index data of every scene, draws address it with first index and vertex offset
 		const de::vulkan::buffer_pool& getVertIndxBufferPool() const { return _bpVertIndx; }
 		de::vulkan::buffer_pool& getVertIndxBufferPool() { return _bpVertIndx; }
 
@@ -97,13 +132,43 @@ namespace de::vulkan
 		const de::vulkan::buffer_pool& getTransferBufferPool() const { return _bpTransfer; }
 		de::vulkan::buffer_pool& getTransferBufferPool() { return _bpTransfer; }
 
-		const de::vulkan::buffer& getCameraDataBuffer() const { return getUniformBufferPool().getBuffer(_cameraDataBufferId); }
+		// indirect draw commands, storage usage so they could be generated on gpu
+		const de::vulkan::buffer_pool& getIndirectBufferPool() const { return _bpIndirect; }
+		de::vulkan::buffer_pool& getIndirectBufferPool() { return _bpIndirect; }
+
+		// draw count above one in single indirect draw call
+		bool isMultiDrawIndirectSupported() const { return _multiDrawIndirect; }
+
+		// draw count read from buffer, so culling could write compacted draws
+		bool isDrawIndirectCountSupported() const { return _drawIndirectCount; }
+
+		culling& getCulling() { return _culling; }
+
+		// host visible and persistently mapped, for data rewritten every frame in its frame slice
+		const de::vulkan::buffer_pool& getFrameUniformBufferPool() const { return _bpFrameUniforms; }
+		de::vulkan::buffer_pool& getFrameUniformBufferPool() { return _bpFrameUniforms; }
+
+		uploader& getUploader() { return _uploader; }
+
+		// summed over views of last drawn frame
+		const draw_stats& getDrawStats() const { return _drawStats; }
+
+		const de::vulkan::buffer_view& getCameraDataBuffer() const { return getFrameUniformBufferPool().getBuffer(_cameraDataBufferId); }
 
-		vk::CommandBuffer beginSingleTimeTransferCommands();
+		// set 0 of every material, data changed once per frame. Slice of current view frame selected by dynamic offset
+		vk::DescriptorSetLayout getFrameDescriptorSetLayout() const { return _frameDescriptorSetLayout; }
+		vk::DescriptorSet getFrameDescriptorSet() const { return _frameDescriptorSet; }
+		uint32_t getFrameDescriptorSetOffset() const;
 
-		void submitSingleTimeTransferCommands(vk::CommandBuffer commandBuffer);
+		// binds whole vertex/index pool buffer as vertex and index buffer, once for every scene drawn after
+		void bindGeometry(vk::CommandBuffer commandBuffer) const;
 
-		void submitSingleTimeTransferCommands(const std::vector<vk::SubmitInfo>& submits);
+		// binds frame set and bindless heap, every material layout compatible with them so they stay bound across pipeline switches
+		void bindGlobalDescriptorSets(vk::CommandBuffer commandBuffer) const;
+
+		vk::CommandBuffer beginSingleTimeGraphicsCommands();
+
+		void submitSingleTimeGraphicsCommands(vk::CommandBuffer commandBuffer);
 
 	protected:
 		void updateCameraBuffer();
@@ -122,8 +187,23 @@ namespace de::vulkan
 
 		void createCameraBuffer();
 
+		void createFrameDescriptorSet();
+
+		// layout of global sets only, materials start their layouts with the same sets
+		void createGlobalPipelineLayout();
+
+		// loaded from disk if saved by the same device and driver, empty otherwise
+		void createPipelineCache();
+
+		void savePipelineCache();
+
 		vk::CommandBuffer prepareCommandBuffer(uint32_t imageIndex);
 
+		void runDeferredDestroys(bool all);
+
+		// records skybox and sorted draw list to secondary command buffers on record threads, executes them in fixed order
+		void recordDrawCommands(view& currentView, vk::CommandBuffer commandBuffer, uint32_t imageIndex);
+
 	private:
 		uint32_t _apiVersion{};
 
@@ -136,6 +216,15 @@ namespace de::vulkan
 		std::array<view::unique, 16> _views;
 		uint32_t _currentDrawViewIndex{};
 
+		uint64_t _frameNumber{};
+
+		struct deferred_destroy
+		{
+			uint64_t _frameNumber;
+			std::function<void()> _destroyFunc;
+		};
+		std::deque<deferred_destroy> _deferredDestroys;
+
 		std::map<std::string, shader::shared> _shaders;
 
 		std::map<std::string, material::unique> _materials;
@@ -146,15 +235,44 @@ namespace de::vulkan
 
 		vk::Device _device;
 
+		vk::PipelineCache _pipelineCache;
+
 		uint32_t _graphicsQueueIndex, _transferQueueIndex;
 		vk::Queue _graphicsQueue, _transferQueue;
-		vk::CommandPool _graphicsCommandPool, _transferCommandPool;
+		vk::CommandPool _graphicsCommandPool;
 
 		camera_data _cameraData;
 		de::vulkan::buffer::id _cameraDataBufferId{std::numeric_limits<de::vulkan::buffer::id>::max()};
 
+		vk::DescriptorSetLayout _frameDescriptorSetLayout;
+		vk::DescriptorPool _frameDescriptorPool;
+		vk::DescriptorSet _frameDescriptorSet;
+
+		vk::PipelineLayout _globalPipelineLayout;
+
 		de::vulkan::buffer_pool _bpVertIndx;
 		de::vulkan::buffer_pool _bpUniforms;
 		de::vulkan::buffer_pool _bpTransfer;
+		de::vulkan::buffer_pool _bpFrameUniforms;
+		de::vulkan::buffer_pool _bpIndirect;
+
+		bool _multiDrawIndirect{false};
+		bool _drawIndirectCount{false};
+
+		culling _culling;
+
+		// rebuilt for every view drawn
+		draw_list _drawList;
+		draw_stats _frameDrawStats;
+		draw_stats _drawStats;
+
+		bindless_heap _bindlessHeap;
+
+		uploader _uploader;
+
+		uint32_t _recordJobCount{1};
+		de::async::thread_pool _recordThreadPool;
+
+		de::async::thread_pool _pipelineThreadPool;
 	};
 } // namespace de::vulkan
\ No newline at end of file
@@ -3,15 +3,19 @@
 #include "core/engine.hxx"
 #include "images/texture_image.hxx"
 #include "renderer/shader_types/material_data.hxx"
+#include "renderer/shader_types/object_data.hxx"
 
 #include "constants.hxx"
 #include "material.hxx"
 #include "renderer.hxx"
 #include "utils.hxx"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <numeric>
 
-void de::vulkan::scene::mesh::init(uint32_t vertexCount, size_t vertexSize, uint32_t vertexOffset, uint32_t indexCount, uint32_t indexOffset)
+void de::vulkan::scene::mesh::init(uint32_t vertexCount, size_t vertexSize, uint32_t vertexOffset, uint32_t indexCount, uint32_t indexOffset, const de::math::aabb& bounds)
 {
 	_vertexCount = vertexCount;
 	_vertexSize = _vertexCount * vertexSize;
@@ -20,19 +24,29 @@ void de::vulkan::scene::mesh::init(uint32_t vertexCount, size_t vertexSize, uint
 	_indexCount = indexCount;
 	_indexSize = _indexCount * sizeof(uint32_t);
 	_indexOffset = indexOffset;
+
+	_bounds = bounds;
 }
 
-void de::vulkan::scene::mesh::drawCmd(vk::CommandBuffer commandBuffer) const
+cull_command de::vulkan::scene::mesh::getCullCommand(int32_t baseVertex, uint32_t baseIndex) const
 {
-	// draw indexed or draw just verts
-	if (_indexCount)
-	{
-		commandBuffer.drawIndexed(_indexCount, 1, _indexOffset, _vertexOffset, 0);
-	}
-	else
-	{
-		commandBuffer.draw(_vertexSize, 1, _vertexOffset, 0);
-	}
+	const auto center = _bounds.getCenter();
+	const auto extent = _bounds.getExtent();
+
+	cull_command out;
+	out._boundsCenter = de::math::vec4(center._x, center._y, center._z, 0.F);
+	out._boundsExtent = de::math::vec4(extent._x, extent._y, extent._z, 0.F);
+	out._indexCount = _indexCount;
+	out._firstIndex = baseIndex + _indexOffset;
+	out._vertexOffset = baseVertex + static_cast<int32_t>(_vertexOffset);
+	out._firstObject = _firstInstance;
+	return out;
+}
+
+void de::vulkan::scene::mesh::setInstances(uint32_t firstInstance, uint32_t instanceCount)
+{
+	_firstInstance = firstInstance;
+	_instanceCount = instanceCount;
 }
 
 vk::DeviceSize de::vulkan::scene::mesh::getVertexSize() const
@@ -67,88 +81,321 @@ void de::vulkan::scene::create(const de::gltf::model& m)
 		return;
 	}
 
-	const size_t imagesNum{m._images.size()};
-	_textureImages.reserve(imagesNum);
-	for (size_t i = 0; i < imagesNum; ++i)
-	{
-		auto& ti = _textureImages.emplace_back(new texture_image());
-		ti->create(m._images[i]);
-	}
-
 	const size_t totalPipelines = m._materials.size();
-	std::vector<material_data> materialsData = std::vector<material_data>(totalPipelines, material_data());
+	_materials = m._materials;
+	_materialsData = std::vector<material_data>(totalPipelines, material_data());
 
 	scene_meshes_info info;
 
+	// every primitive geometry stored once, nodes only add instances to it
 	_meshes.resize(totalPipelines);
+	info._primitiveMeshes.resize(m._meshes.size());
+	for (size_t i = 0; i < m._meshes.size(); ++i)
+	{
+		for (const auto& primitive : m._meshes[i]._primitives)
+		{
+			if (primitive._material >= totalPipelines)
+			{
+				info._primitiveMeshes[i].push_back(nullptr);
+				continue;
+			}
+
+			const uint32_t* indexes = primitive._indexes.data();
+			uint32_t indexCount = primitive._indexes.size();
+			if (primitive._indexes.empty())
+			{
+				auto& generated = info._generatedIndexes.emplace_back(primitive._vertexes.size());
+				std::iota(generated.begin(), generated.end(), 0);
+				indexes = generated.data();
+				indexCount = generated.size();
+			}
+
+			auto& newMesh = _meshes[primitive._material].emplace_back(new scene::mesh());
+			newMesh->init(primitive._vertexes.size(), sizeof(primitive._vertexes[0]), info._totalVertexSize / sizeof(de::gltf::mesh::primitive::vertex), indexCount, info._totalIndexSize / sizeof(uint32_t), primitive._bounds);
+			info._primitiveMeshes[i].push_back(newMesh.get());
+
+			const uint32_t vertexSize = newMesh->getVertexSize();
+			info._vertexMemRegions.emplace_back(device_memory::map_memory_region{primitive._vertexes.data(), vertexSize, info._totalVertexSize});
+			info._totalVertexSize += vertexSize;
+
+			const uint32_t indexSize = newMesh->getIndexSize();
+			info._indexMemRegions.emplace_back(device_memory::map_memory_region{indexes, indexSize, info._totalIndexSize});
+			info._totalIndexSize += indexSize;
+		}
+	}
+
 	const auto& scene = m._scenes[m._sceneIndex];
 	for (const auto nodeIndex : scene._nodes)
 	{
 		recurseSceneNodes(m, m._nodes[nodeIndex], de::math::transform(), info);
 	}
 
+	allocateMeshesBuffers(info);
+
+	// instances of the same mesh laid out next to each other, so each mesh is single indirect command.
+	// commands of material laid out next to each other, so material drawn with single indirect draw
+	std::vector<object_data> objects;
+	std::vector<cull_command> commands;
+	std::vector<de::math::aabb> commandBounds;
+	_drawRanges.resize(totalPipelines);
+	for (size_t i = 0; i < totalPipelines; ++i)
+	{
+		_drawRanges[i]._firstCommand = commands.size();
+		for (const auto& mesh : _meshes[i])
+		{
+			const auto& instances = info._meshInstances[mesh.get()];
+			mesh->setInstances(objects.size(), instances.size());
+			if (instances.empty())
+				continue;
+
+			auto& command = commands.emplace_back(mesh->getCullCommand(_baseVertex, _baseIndex));
+			command._materialIndex = static_cast<uint32_t>(i);
+			command._materialFirstCommand = _drawRanges[i]._firstCommand;
+
+			const uint32_t commandIndex = commands.size() - 1;
+			auto& bounds = commandBounds.emplace_back();
+			for (const auto& instance : instances)
+			{
+				objects.push_back(object_data{._model = instance, ._materialIndex = static_cast<uint32_t>(i), ._commandIndex = commandIndex});
+				bounds.extend(mesh->getBounds().transform(instance));
+			}
+			_drawRanges[i]._bounds.extend(bounds);
+		}
+		_drawRanges[i]._commandCount = commands.size() - _drawRanges[i]._firstCommand;
+	}
+
+	// every mesh visible until first cull
+	_bvh.build(commandBounds);
+	_visibleCommands.assign(commandBounds.size(), 1);
+	_visibleCommandCount = commandBounds.size();
+	_visibleMaterialCommands.resize(totalPipelines);
+	std::transform(_drawRanges.begin(), _drawRanges.end(), _visibleMaterialCommands.begin(), [](const draw_range& range)
+		{ return range._commandCount; });
+	if (objects.empty())
+	{
+		objects.emplace_back();
+	}
+	if (commands.empty())
+	{
+		commands.emplace_back();
+	}
+
 	info._materialMemRegions.reserve(totalPipelines);
 	for (size_t i = 0; i < totalPipelines; ++i)
 	{
-		materialsData[i] = material_data(m._materials[i]);
+		_materialsData[i] = material_data(m._materials[i]);
 
-		info._materialMemRegions.emplace_back(device_memory::map_memory_region{&materialsData[i], sizeof(material_data), info._totalMaterialsSize});
-		info._totalMaterialsSize += sizeof(materialsData[i]);
+		info._materialMemRegions.emplace_back(device_memory::map_memory_region{&_materialsData[i], sizeof(material_data), info._totalMaterialsSize});
+		info._totalMaterialsSize += sizeof(_materialsData[i]);
 	}
 
-	createMeshesBuffer(info);
-	createMaterialsBuffer(info);
+	const uint32_t objectsSize = objects.size() * sizeof(object_data);
+	const uint32_t commandsSize = commands.size() * sizeof(cull_command);
 
-	const auto basicMat = renderer->getMaterial(de::vulkan::constants::materials::basic);
+	// every transfer of the scene recorded to single batch and submitted once
+	auto& uploader = renderer->getUploader();
+	vk::DeviceSize stagingBudget = uploader.getStagingSize(info._totalVertexSize) + uploader.getStagingSize(info._totalIndexSize) +
+								   uploader.getStagingSize(info._totalMaterialsSize) + uploader.getStagingSize(objectsSize) +
+								   uploader.getStagingSize(commandsSize);
+	for (const auto& image : m._images)
+	{
+		stagingBudget += uploader.getStagingSize(image._pixels.size());
+	}
+	uploader.beginBatch(stagingBudget);
 
+	// images without pixels are streamed later with setTextureImage, placeholder used until then
+	const size_t imagesNum{m._images.size()};
+	_textureImages.reserve(imagesNum);
+	for (size_t i = 0; i < imagesNum; ++i)
+	{
+		auto& ti = _textureImages.emplace_back(new texture_image());
+		if (!m._images[i]._pixels.empty())
+		{
+			ti->create(m._images[i]);
+		}
+	}
+
+	// images uploaded in the same batch, so materials refer to their slots from the start
 	for (size_t i = 0; i < totalPipelines; ++i)
 	{
-		const auto& matData = materialsData[i];
+		updateMaterialTextures(i);
+	}
+
+	createMeshesBuffer(info);
+	_materialsBufferId = createUniformBuffer(info._materialMemRegions, info._totalMaterialsSize);
+	_objectsBufferId = createUniformBuffer({device_memory::map_memory_region{objects.data(), objectsSize, 0}}, objectsSize);
+	_cullCommandsBufferId = createUniformBuffer({device_memory::map_memory_region{commands.data(), commandsSize, 0}}, commandsSize);
+
+	_uploadTicket = uploader.endBatch();
+
+	// culling outputs written by gpu for every view frame, so scene data shared by all views
+	auto& bpUniforms = renderer->getUniformBufferPool();
+	auto& bpIndirect = renderer->getIndirectBufferPool();
+	const uint32_t sliceCount = renderer->getFrameSliceCount();
+	const uint32_t objectCount = objects.size();
+	const uint32_t commandCount = commands.size();
+
+	_visibleObjectsBufferId = bpUniforms.makeBuffer(sliceCount * objectCount * sizeof(uint32_t));
+	if (std::any_of(_drawRanges.begin(), _drawRanges.end(), [](const draw_range& range)
+			{ return range._commandCount != 0; }))
+	{
+		_instanceCountsBufferId = bpUniforms.makeBuffer(sliceCount * commandCount * sizeof(uint32_t));
+		_indirectBufferId = bpIndirect.makeBuffer(sliceCount * commandCount * sizeof(vk::DrawIndexedIndirectCommand));
+		_drawCountsBufferId = bpIndirect.makeBuffer(sliceCount * totalPipelines * sizeof(uint32_t));
+
+		culling::scene_bindings bindings;
+		bindings._objects = &bpUniforms.getBuffer(_objectsBufferId);
+		bindings._commands = &bpUniforms.getBuffer(_cullCommandsBufferId);
+		bindings._instanceCounts = &bpUniforms.getBuffer(_instanceCountsBufferId);
+		bindings._visibleObjects = &bpUniforms.getBuffer(_visibleObjectsBufferId);
+		bindings._drawCommands = &bpIndirect.getBuffer(_indirectBufferId);
+		bindings._drawCounts = &bpIndirect.getBuffer(_drawCountsBufferId);
+		_cullDispatch = renderer->getCulling().makeSceneDispatch(bindings, objectCount, commandCount, totalPipelines);
+	}
 
+	const auto basicMat = renderer->getMaterial(de::vulkan::constants::materials::basic);
+	for (size_t i = 0; i < totalPipelines; ++i)
+	{
 		auto mat = _matInstances.emplace_back(basicMat->makeInstance());
 
-		mat->setBufferDependency("cameraData", &renderer->getCameraDataBuffer());
+		mat->setBufferDependency("objects", &renderer->getUniformBufferPool().getBuffer(_objectsBufferId));
+		mat->setBufferDependency("visibleObjects", &renderer->getUniformBufferPool().getBuffer(_visibleObjectsBufferId));
+		mat->setBufferDependency("materials", &renderer->getUniformBufferPool().getBuffer(_materialsBufferId));
+		mat->updateDescriptorSets();
+	}
+}
 
-		const auto baseColorIndex = m._materials[i]._pbrMetallicRoughness._baseColorTexture._index;
-		const auto metallicRoughnessIndex = m._materials[i]._pbrMetallicRoughness._metallicRoughnessTexture._index;
-		const auto emissiveIndex = m._materials[i]._emissive._index;
-		const auto normalIndex = m._materials[i]._normal._index;
+void de::vulkan::scene::setTextureImage(uint32_t index, const de::gltf::image& image)
+{
+	if (index >= _textureImages.size())
+	{
+		DE_LOG(Error, "%s: Image index %u out of range", __FUNCTION__, index);
+		return;
+	}
 
-		if (matData._hasBaseColor)
-			mat->setImageDependecy("baseColor", _textureImages[baseColorIndex].get());
-		if (matData._hasMetallicRoughness)
-			mat->setImageDependecy("metallicRoughness", _textureImages[metallicRoughnessIndex].get());
-		if (matData._hasEmissive)
-			mat->setImageDependecy("emissive", _textureImages[emissiveIndex].get());
-		if (matData._hasNormal)
-			mat->setImageDependecy("normal", _textureImages[normalIndex].get());
+	_pendingImages.push_back(index);
 
-		mat->setBufferDependency("mat", &renderer->getUniformBufferPool().getBuffer(_materialsBufferId));
-		mat->updateDescriptorSets();
+	auto& textureImage = _textureImages[index];
+	if (textureImage->isValid())
+	{
+		// materials buffer frames in flight read refers to slot of old image, it destroyed once buffer without it in use
+		_retiredImages.emplace_back(std::move(textureImage));
+
+		textureImage.reset(new texture_image());
+		updateMaterialsUsingImage(index);
 	}
+
+	textureImage->create(image);
 }
 
-void de::vulkan::scene::recurseSceneNodes(const de::gltf::model& m, const de::gltf::node& selfNode, const de::math::transform& rootTransform, scene_meshes_info& info)
+void de::vulkan::scene::tick()
 {
-	const auto newTransform = selfNode._transform + rootTransform;
-	if (selfNode._mesh != UINT32_MAX)
+	auto renderer = renderer::get();
+	const auto& uploader = renderer->getUploader();
+
+	if (!_pendingImages.empty())
 	{
-		const auto& mesh = m._meshes[selfNode._mesh];
-		for (const auto& primitive : mesh._primitives)
+		const auto firstPending = std::partition(_pendingImages.begin(), _pendingImages.end(), [this, &uploader](uint32_t index)
+			{ return uploader.isComplete(_textureImages[index]->getUploadTicket()); });
+
+		const std::vector<uint32_t> readyImages(_pendingImages.begin(), firstPending);
+		_pendingImages.erase(_pendingImages.begin(), firstPending);
+		for (const auto index : readyImages)
 		{
-			auto& meshes = _meshes[primitive._material];
-			auto& newMesh = meshes.emplace_back(new scene::mesh());
+			updateMaterialsUsingImage(index);
+		}
+	}
 
-			newMesh->init(primitive._vertexes.size(), sizeof(primitive._vertexes[0]), info._totalVertexSize / sizeof(de::gltf::mesh::primitive::vertex), primitive._indexes.size(), info._totalIndexSize / sizeof(uint32_t));
-			newMesh->_mat = de::math::mat4::makeTransform(newTransform);
+	updateMaterialsBuffer();
+}
 
-			const uint32_t vertexSize = newMesh->getVertexSize();
-			info._vertexMemRegions.emplace_back(device_memory::map_memory_region{primitive._vertexes.data(), vertexSize, info._totalVertexSize});
-			info._totalVertexSize += vertexSize;
+void de::vulkan::scene::updateMaterialsBuffer()
+{
+	auto renderer = renderer::get();
+	auto& uploader = renderer->getUploader();
+	auto& bpUniforms = renderer->getUniformBufferPool();
 
-			const uint32_t indexSize = newMesh->getIndexSize();
-			info._indexMemRegions.emplace_back(device_memory::map_memory_region{primitive._indexes.data(), indexSize, info._totalIndexSize});
-			info._totalIndexSize += indexSize;
+	// frames recorded from now on read new buffer, old one and images only it referred to freed after frames in flight
+	if (_pendingMaterialsBufferId != std::numeric_limits<buffer::id>::max() && uploader.isComplete(_materialsUploadTicket))
+	{
+		renderer->deferDestroy([&bpUniforms, bufferId = _materialsBufferId, images = std::move(_uploadingRetiredImages)]()
+			{
+				bpUniforms.freeBuffer(bufferId);
+				for (const auto& image : images)
+					image->destroy();
+			});
+		_uploadingRetiredImages.clear();
+
+		_materialsBufferId = _pendingMaterialsBufferId;
+		_pendingMaterialsBufferId = std::numeric_limits<buffer::id>::max();
+		for (auto mat : _matInstances)
+		{
+			mat->setBufferDependency("materials", &bpUniforms.getBuffer(_materialsBufferId));
+			mat->updateDescriptorSets();
+		}
+	}
+
+	// single upload in flight, later changes go with the next one
+	if (_materialsDirty && _pendingMaterialsBufferId == std::numeric_limits<buffer::id>::max())
+	{
+		const uint32_t size = _materialsData.size() * sizeof(material_data);
+		_pendingMaterialsBufferId = bpUniforms.makeBuffer(size);
+		_materialsUploadTicket = uploader.uploadBuffer(bpUniforms.getBuffer(_pendingMaterialsBufferId), _materialsData.data(), size);
+		_uploadingRetiredImages = std::move(_retiredImages);
+		_retiredImages.clear();
+		_materialsDirty = false;
+	}
+}
+
+void de::vulkan::scene::updateMaterialsUsingImage(uint32_t imageIndex)
+{
+	const size_t totalMaterials = _materials.size();
+	for (size_t i = 0; i < totalMaterials; ++i)
+	{
+		const auto& material = _materials[i];
+		if (material._pbrMetallicRoughness._baseColorTexture._index == imageIndex ||
+			material._pbrMetallicRoughness._metallicRoughnessTexture._index == imageIndex ||
+			material._emissive._index == imageIndex ||
+			material._normal._index == imageIndex)
+		{
+			updateMaterialTextures(i);
+			_materialsDirty = true;
+		}
+	}
+}
+
+void de::vulkan::scene::updateMaterialTextures(size_t materialIndex)
+{
+	const auto& material = _materials[materialIndex];
+	auto& data = _materialsData[materialIndex];
+
+	data._baseColorTexture = getTextureImageFromIndex(material._pbrMetallicRoughness._baseColorTexture._index).getBindlessIndex();
+	data._metallicRoughnessTexture = getTextureImageFromIndex(material._pbrMetallicRoughness._metallicRoughnessTexture._index).getBindlessIndex();
+	data._emissiveTexture = getTextureImageFromIndex(material._emissive._index).getBindlessIndex();
+	data._normalTexture = getTextureImageFromIndex(material._normal._index).getBindlessIndex();
+}
+
+void de::vulkan::scene::recurseSceneNodes(const de::gltf::model& m, const de::gltf::node& selfNode, const de::math::transform& rootTransform, scene_meshes_info& info)
+{
+	const auto newTransform = selfNode._transform + rootTransform;
+	if (selfNode._mesh != UINT32_MAX)
+	{
+		const auto nodeMat = de::math::mat4::makeTransform(newTransform);
+		for (const auto mesh : info._primitiveMeshes[selfNode._mesh])
+		{
+			if (mesh == nullptr)
+				continue;
+
+			auto& instances = info._meshInstances[mesh];
+			if (selfNode._instances.empty())
+			{
+				instances.push_back(nodeMat);
+			}
+			// instance transform is in node local space, so applied before node one
+			for (const auto& instanceMat : selfNode._instances)
+			{
+				instances.push_back(instanceMat * nodeMat);
+			}
 		}
 	}
 	for (const auto& childNodeIndex : selfNode._children)
@@ -157,82 +404,109 @@ void de::vulkan::scene::recurseSceneNodes(const de::gltf::model& m, const de::gl
 	}
 }
 
-void de::vulkan::scene::createMeshesBuffer(const scene_meshes_info& info)
+void de::vulkan::scene::allocateMeshesBuffers(const scene_meshes_info& info)
 {
-	_indexOffset = info._totalVertexSize;
+	auto& bpVertIndx = renderer::get()->getVertIndxBufferPool();
+
+	// offsets multiple of element size, so they are whole vertex and index of pool buffer
+	constexpr vk::DeviceSize vertexStride = sizeof(de::gltf::mesh::primitive::vertex);
+	_meshesVertexBufferId = bpVertIndx.makeBuffer(std::max<vk::DeviceSize>(info._totalVertexSize, vertexStride), vertexStride);
+	_meshesIndexBufferId = bpVertIndx.makeBuffer(std::max<vk::DeviceSize>(info._totalIndexSize, sizeof(uint32_t)), sizeof(uint32_t));
 
-	const auto size = info._totalVertexSize + info._totalIndexSize + info._totalMaterialsSize;
+	_baseVertex = static_cast<int32_t>(bpVertIndx.getBuffer(_meshesVertexBufferId).getOffset() / vertexStride);
+	_baseIndex = static_cast<uint32_t>(bpVertIndx.getBuffer(_meshesIndexBufferId).getOffset() / sizeof(uint32_t));
+}
 
+void de::vulkan::scene::createMeshesBuffer(const scene_meshes_info& info)
+{
 	auto renderer = renderer::get();
-	auto& bpTransfer = renderer->getTransferBufferPool();
 	auto& bpVertIndx = renderer->getVertIndxBufferPool();
+	auto& uploader = renderer->getUploader();
 
-	const auto transferBufferId = bpTransfer.makeBuffer(size);
-	auto region = bpTransfer.map(transferBufferId);
-	for (const auto& reg : info._vertexMemRegions)
+	if (info._totalVertexSize != 0)
 	{
-		memcpy(reinterpret_cast<uint8_t*>(region) + reg.offset, reg.data, reg.size);
+		uploader.uploadBuffer(bpVertIndx.getBuffer(_meshesVertexBufferId), info._vertexMemRegions, info._totalVertexSize);
 	}
-	for (const auto& reg : info._indexMemRegions)
+	if (info._totalIndexSize != 0)
 	{
-		memcpy(reinterpret_cast<uint8_t*>(region) + reg.offset + _indexOffset, reg.data, reg.size);
+		uploader.uploadBuffer(bpVertIndx.getBuffer(_meshesIndexBufferId), info._indexMemRegions, info._totalIndexSize);
 	}
-	bpTransfer.unmap(transferBufferId);
+}
 
-	_meshesVIBufferId = bpVertIndx.makeBuffer(size);
+de::vulkan::buffer::id de::vulkan::scene::createUniformBuffer(const std::vector<device_memory::map_memory_region>& regions, uint32_t size)
+{
+	auto renderer = renderer::get();
+	auto& bpUniform = renderer->getUniformBufferPool();
 
-	const vk::BufferCopy copyRegion = vk::BufferCopy(0, 0, size);
-	de::vulkan::buffer::copyBuffer(bpTransfer.getBuffer(transferBufferId).get(), bpVertIndx.getBuffer(_meshesVIBufferId).get(), {copyRegion});
+	const auto bufferId = bpUniform.makeBuffer(size);
+	renderer->getUploader().uploadBuffer(bpUniform.getBuffer(bufferId), regions, size);
 
-	bpTransfer.freeBuffer(transferBufferId);
+	return bufferId;
 }
 
-void de::vulkan::scene::createMaterialsBuffer(const scene_meshes_info& info)
+void de::vulkan::scene::cullMeshes(const de::math::frustum& frustum)
 {
-	auto size = info._totalMaterialsSize;
-
-	auto renderer = renderer::get();
-	auto& bpTransfer = renderer->getTransferBufferPool();
-	auto& bpUniform = renderer->getUniformBufferPool();
+	std::fill(_visibleCommands.begin(), _visibleCommands.end(), 0);
+	_visibleCommandCount = 0;
+	_bvh.query(frustum, [this](uint32_t command)
+		{
+			_visibleCommands[command] = 1;
+			++_visibleCommandCount;
+		});
 
-	const auto transferBufferId = bpTransfer.makeBuffer(size);
-	auto region = bpTransfer.map(transferBufferId);
-	for (const auto& reg : info._materialMemRegions)
+	for (size_t i = 0; i < _drawRanges.size(); ++i)
 	{
-		memcpy(reinterpret_cast<uint8_t*>(region) + reg.offset, reg.data, reg.size);
+		const auto first = _visibleCommands.begin() + _drawRanges[i]._firstCommand;
+		_visibleMaterialCommands[i] = std::count(first, first + _drawRanges[i]._commandCount, 1);
 	}
-	bpTransfer.unmap(transferBufferId);
-
-	_materialsBufferId = bpUniform.makeBuffer(size);
-
-	const vk::BufferCopy copyRegion = vk::BufferCopy(0, 0, size);
-	de::vulkan::buffer::copyBuffer(bpTransfer.getBuffer(transferBufferId).get(), bpUniform.getBuffer(_materialsBufferId).get(), {copyRegion});
+}
 
-	bpTransfer.freeBuffer(transferBufferId);
+const de::vulkan::culling::scene_dispatch* de::vulkan::scene::getCullDispatch() const
+{
+	if (!_cullDispatch._pool || _visibleCommandCount == 0 || !renderer::get()->getUploader().isComplete(_uploadTicket))
+		return nullptr;
+	return &_cullDispatch;
 }
 
-void de::vulkan::scene::bindToCmdBuffer(vk::CommandBuffer commandBuffer)
+void de::vulkan::scene::drawMaterial(vk::CommandBuffer commandBuffer, size_t materialIndex) const
 {
-	const auto vertIndexBuffer = renderer::get()->getVertIndxBufferPool().getBuffer(_meshesVIBufferId).get();
+	auto renderer = renderer::get();
 
-	std::array<vk::DeviceSize, 1> offsets{0};
-	commandBuffer.bindVertexBuffers(0, vertIndexBuffer, offsets);
-	commandBuffer.bindIndexBuffer(vertIndexBuffer, _indexOffset, vk::IndexType::eUint32);
+	const auto& indirectBuffer = renderer->getIndirectBufferPool().getBuffer(_indirectBufferId);
+	const auto& drawCountsBuffer = renderer->getIndirectBufferPool().getBuffer(_drawCountsBufferId);
+	constexpr uint32_t commandStride = sizeof(vk::DrawIndexedIndirectCommand);
 
-	const size_t totalMaterials = _matInstances.size();
-	for (size_t i = 0; i < totalMaterials; ++i)
-	{
-		auto matInst = _matInstances[i];
-		auto mat = matInst->getMaterial();
+	// draws culled for current view frame
+	const uint32_t sliceIndex = renderer->getFrameSliceIndex();
+	const vk::DeviceSize sliceOffset = indirectBuffer.getOffset() + sliceIndex * _cullDispatch._commandCount * commandStride;
+	const vk::DeviceSize sliceDrawCountsOffset = drawCountsBuffer.getOffset() + sliceIndex * _cullDispatch._materialCount * sizeof(uint32_t);
 
-		auto& meshes = _meshes[i];
+	const auto& drawRange = _drawRanges[materialIndex];
+	const vk::DeviceSize offset = sliceOffset + drawRange._firstCommand * commandStride;
+	if (renderer->isDrawIndirectCountSupported())
+	{
+		commandBuffer.drawIndexedIndirectCount(indirectBuffer.get(), offset, drawCountsBuffer.get(), sliceDrawCountsOffset + materialIndex * sizeof(uint32_t), drawRange._commandCount, commandStride);
+	}
+	else if (renderer->isMultiDrawIndirectSupported())
+	{
+		// commands written in place, so runs of visible ones drawn
+		for (uint32_t k = 0; k < drawRange._commandCount;)
+		{
+			uint32_t count = 0;
+			while (k + count < drawRange._commandCount && _visibleCommands[drawRange._firstCommand + k + count])
+				++count;
 
-		mat->bindCmd(commandBuffer);
-		matInst->bindCmd(commandBuffer);
-		for (const auto& mesh : meshes)
+			if (count != 0)
+				commandBuffer.drawIndexedIndirect(indirectBuffer.get(), offset + k * commandStride, count, commandStride);
+			k += std::max(count, 1U);
+		}
+	}
+	else
+	{
+		for (uint32_t k = 0; k < drawRange._commandCount; ++k)
 		{
-			commandBuffer.pushConstants(mat->getPipelineLayout(), vk::ShaderStageFlagBits::eVertex, 0, sizeof(de::math::mat4), &mesh->_mat);
-			mesh->drawCmd(commandBuffer);
+			if (_visibleCommands[drawRange._firstCommand + k])
+				commandBuffer.drawIndexedIndirect(indirectBuffer.get(), offset + k * commandStride, 1, commandStride);
 		}
 	}
 }
@@ -244,21 +518,76 @@ bool de::vulkan::scene::isEmpty() const
 
 void de::vulkan::scene::destroy()
 {
+	// pool ranges must not be reused while copies into them pending
+	auto renderer = renderer::get();
+	renderer->getUploader().wait(_uploadTicket);
+	renderer->getUploader().wait(_materialsUploadTicket);
+
+	// frames in flight may still sample scene images, so they are destroyed with pool buffers
+	std::vector<std::shared_ptr<texture_image>> images(std::move(_retiredImages));
+	images.insert(images.end(), _uploadingRetiredImages.begin(), _uploadingRetiredImages.end());
+	for (auto& image : _textureImages)
+	{
+		images.emplace_back(std::move(image));
+	}
 	_textureImages.clear();
+	_pendingImages.clear();
+	_retiredImages.clear();
+	_uploadingRetiredImages.clear();
 
+	_materials.clear();
+	_materialsData.clear();
+	_materialsDirty = false;
+
+	for (auto matInst : _matInstances)
+	{
+		matInst->getMaterial()->removeInstance(matInst);
+	}
 	_matInstances.clear();
 
 	_meshes.clear();
-
-	auto renderer = renderer::get();
-	renderer->getVertIndxBufferPool().freeBuffer(_meshesVIBufferId);
-	renderer->getUniformBufferPool().freeBuffer(_materialsBufferId);
+	_drawRanges.clear();
+	_bvh.clear();
+	_visibleCommands.clear();
+	_visibleMaterialCommands.clear();
+	_visibleCommandCount = 0;
+
+	// frames in flight may still draw from pool ranges of the scene, so they are not reused until done
+	renderer->deferDestroy([renderer, images = std::move(images),
+							   vertIndxBuffers = std::array{_meshesVertexBufferId, _meshesIndexBufferId},
+							   uniformBuffers = std::array{_materialsBufferId, _pendingMaterialsBufferId, _objectsBufferId, _cullCommandsBufferId, _visibleObjectsBufferId, _instanceCountsBufferId},
+							   indirectBuffers = std::array{_indirectBufferId, _drawCountsBufferId}]()
+		{
+			for (const auto id : vertIndxBuffers)
+				renderer->getVertIndxBufferPool().freeBuffer(id);
+			for (const auto id : uniformBuffers)
+				renderer->getUniformBufferPool().freeBuffer(id);
+			for (const auto id : indirectBuffers)
+				renderer->getIndirectBufferPool().freeBuffer(id);
+			for (const auto& image : images)
+				image->destroy();
+		});
+
+	renderer->getCulling().freeSceneDispatch(_cullDispatch);
+
+	_meshesVertexBufferId = std::numeric_limits<buffer::id>::max();
+	_meshesIndexBufferId = std::numeric_limits<buffer::id>::max();
+	_materialsBufferId = std::numeric_limits<buffer::id>::max();
+	_pendingMaterialsBufferId = std::numeric_limits<buffer::id>::max();
+	_objectsBufferId = std::numeric_limits<buffer::id>::max();
+	_cullCommandsBufferId = std::numeric_limits<buffer::id>::max();
+	_visibleObjectsBufferId = std::numeric_limits<buffer::id>::max();
+	_instanceCountsBufferId = std::numeric_limits<buffer::id>::max();
+	_indirectBufferId = std::numeric_limits<buffer::id>::max();
+	_drawCountsBufferId = std::numeric_limits<buffer::id>::max();
 }
 
 const de::vulkan::texture_image& de::vulkan::scene::getTextureImageFromIndex(uint32_t index) const
 {
+	// images created with scene uploaded together with it, streamed ones bound only once upload complete
 	const auto& placeholder = renderer::get()->getTextureImagePlaceholder();
-	if (index < _textureImages.size() && _textureImages[index]->isValid())
+	const bool isPending = std::find(_pendingImages.begin(), _pendingImages.end(), index) != _pendingImages.end();
+	if (index < _textureImages.size() && _textureImages[index]->isValid() && !isPending)
 	{
 		return *_textureImages[index];
 	}
@@ -1,11 +1,19 @@
 #pragma once
 #include "gltf/model.hxx"
+#include "math/aabb.hxx"
+#include "math/bvh.hxx"
+#include "math/frustum.hxx"
 #include "math/transform.hxx"
+#include "renderer/shader_types/cull_command.hxx"
+#include "renderer/shader_types/material_data.hxx"
 #include "vulkan/vulkan.h"
 
 #include "buffer.hxx"
+#include "culling.hxx"
 #include "material.hxx"
+#include "uploader.hxx"
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -20,12 +28,18 @@ namespace de::vulkan
 		class mesh final
 		{
 		public:
-			void init(uint32_t vertexCount, size_t vertexSize, uint32_t vertexOffset, uint32_t indexCount, uint32_t indexOffset);
+			void init(uint32_t vertexCount, size_t vertexSize, uint32_t vertexOffset, uint32_t indexCount, uint32_t indexOffset, const de::math::aabb& bounds);
 
-			void drawCmd(vk::CommandBuffer commandBuffer) const;
+			// range of mesh objects in scene objects buffer
+			void setInstances(uint32_t firstInstance, uint32_t instanceCount);
 
-			// temporal hold of the mesh matrix (transform)
-			de::math::mat4 _mat;
+			uint32_t getInstanceCount() const { return _instanceCount; }
+
+			const de::math::aabb& getBounds() const { return _bounds; }
+
+			// command of all mesh instances, culling writes draw of visible ones from it.
+			// mesh offsets are local to scene geometry, base ones place it in vertex/index pool buffer
+			cull_command getCullCommand(int32_t baseVertex, uint32_t baseIndex) const;
 
 			vk::DeviceSize getVertexSize() const;
 			vk::DeviceSize getIndexSize() const;
@@ -38,6 +52,11 @@ namespace de::vulkan
 			uint32_t _indexOffset{0};
 			vk::DeviceSize _indexSize{0};
 			vk::DeviceSize _indexCount{0};
+
+			uint32_t _firstInstance{0};
+			uint32_t _instanceCount{0};
+
+			de::math::aabb _bounds;
 		};
 
 	public:
@@ -46,7 +65,27 @@ namespace de::vulkan
 
 		void create(const de::gltf::model& m);
 
-		void bindToCmdBuffer(vk::CommandBuffer commandBuffer);
+		// point materials to streamed images once their uploads complete
+		void tick();
+
+		// culled draws of material meshes for current view frame, renderer geometry and material instance bound already
+		void drawMaterial(vk::CommandBuffer commandBuffer, size_t materialIndex) const;
+
+		size_t getMaterialCount() const { return _matInstances.size(); }
+
+		material_instance* getMaterialInstance(size_t materialIndex) const { return _matInstances[materialIndex]; }
+
+		// some mesh of material passed last cullMeshes
+		bool isMaterialVisible(size_t materialIndex) const { return _visibleMaterialCommands[materialIndex] != 0; }
+
+		// world bounds of every mesh instance of material
+		const de::math::aabb& getMaterialBounds(size_t materialIndex) const { return _drawRanges[materialIndex]._bounds; }
+
+		// test meshes against frustum of view about to be drawn, invisible ones skipped by culling and draws of the view
+		void cullMeshes(const de::math::frustum& frustum);
+
+		// nullptr until scene buffers uploaded or if scene has nothing to draw
+		const culling::scene_dispatch* getCullDispatch() const;
 
 		bool isEmpty() const;
 
@@ -56,6 +95,9 @@ namespace de::vulkan
 		const std::vector<std::unique_ptr<texture_image>>& getTextureImages() const { return _textureImages; }
 		const texture_image& getTextureImageFromIndex(uint32_t index) const;
 
+		// upload streamed image, materials that use it sample placeholder until then
+		void setTextureImage(uint32_t index, const de::gltf::image& image);
+
 	private:
 		struct scene_meshes_info
 		{
@@ -67,21 +109,81 @@ namespace de::vulkan
 
 			uint32_t _totalMaterialsSize{0};
 			std::vector<device_memory::map_memory_region> _materialMemRegions;
+
+			// sequential indexes of primitives without them, so every mesh drawn indexed
+			std::vector<std::vector<uint32_t>> _generatedIndexes;
+
+			// scene meshes of every gltf mesh primitive, nullptr if primitive skipped
+			std::vector<std::vector<mesh*>> _primitiveMeshes;
+			std::map<const mesh*, std::vector<de::math::mat4>> _meshInstances;
 		};
 
 		void recurseSceneNodes(const de::gltf::model& m, const de::gltf::node& selfNode, const de::math::transform& rootTransform, scene_meshes_info& info);
 
+		// vertex and index ranges of the scene in renderer vertex/index pool, before commands refer to them
+		void allocateMeshesBuffers(const scene_meshes_info& info);
 		void createMeshesBuffer(const scene_meshes_info& info);
-		void createMaterialsBuffer(const scene_meshes_info& info);
+		buffer::id createUniformBuffer(const std::vector<device_memory::map_memory_region>& regions, uint32_t size);
+
+		// bindless slots of material images to its data, uploaded with next materials buffer
+		void updateMaterialTextures(size_t materialIndex);
+
+		// materials buffer read by frames in flight, so changed data uploaded to new one and swapped once complete
+		void updateMaterialsBuffer();
+
+		void updateMaterialsUsingImage(uint32_t imageIndex);
 
 		std::vector<std::unique_ptr<texture_image>> _textureImages;
 
+		// streamed images still uploading, placeholder bound instead
+		std::vector<uint32_t> _pendingImages;
+
+		std::vector<de::gltf::material> _materials;
+		std::vector<material_data> _materialsData;
+		bool _materialsDirty{false};
+
+		// replaced streamed images, kept until materials buffer referring to them no longer in use
+		std::vector<std::shared_ptr<texture_image>> _retiredImages;
+		std::vector<std::shared_ptr<texture_image>> _uploadingRetiredImages;
+
 		std::vector<material_instance*> _matInstances;
 
 		std::vector<std::vector<std::unique_ptr<mesh>>> _meshes;
 
-		uint32_t _indexOffset;
-		buffer::id _meshesVIBufferId;
-		buffer::id _materialsBufferId;
+		// commands of material meshes in scene commands buffer, compacted draws of them written from the same index
+		struct draw_range
+		{
+			uint32_t _firstCommand{};
+			uint32_t _commandCount{};
+			de::math::aabb _bounds;
+		};
+		std::vector<draw_range> _drawRanges;
+
+		// world bounds of every command mesh instances, commands tested against view frustum with it
+		de::math::bvh _bvh;
+		std::vector<uint8_t> _visibleCommands;
+		std::vector<uint32_t> _visibleMaterialCommands;
+		uint32_t _visibleCommandCount{};
+
+		buffer::id _meshesVertexBufferId{std::numeric_limits<buffer::id>::max()};
+		buffer::id _meshesIndexBufferId{std::numeric_limits<buffer::id>::max()};
+		int32_t _baseVertex{};
+		uint32_t _baseIndex{};
+		buffer::id _materialsBufferId{std::numeric_limits<buffer::id>::max()};
+		buffer::id _pendingMaterialsBufferId{std::numeric_limits<buffer::id>::max()};
+		uploader::ticket _materialsUploadTicket{};
+		buffer::id _objectsBufferId{std::numeric_limits<buffer::id>::max()};
+		buffer::id _cullCommandsBufferId{std::numeric_limits<buffer::id>::max()};
+
+		// per frame slice outputs of culling
+		buffer::id _visibleObjectsBufferId{std::numeric_limits<buffer::id>::max()};
+		buffer::id _instanceCountsBufferId{std::numeric_limits<buffer::id>::max()};
+		buffer::id _indirectBufferId{std::numeric_limits<buffer::id>::max()};
+		buffer::id _drawCountsBufferId{std::numeric_limits<buffer::id>::max()};
+
+		culling::scene_dispatch _cullDispatch;
+
+		// last upload of scene buffers
+		uploader::ticket _uploadTicket{};
 	};
 } // namespace de::vulkan
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "settings.hxx"
 
+#include "constants.hxx"
 #include "renderer.hxx"
 #include "utils.hxx"
 
+#include <algorithm>
+
 void de::vulkan::settings::init()
 {
 	const vk::PhysicalDevice physicalDevice = renderer::get()->getPhysicalDevice();
@@ -24,6 +27,11 @@ vk::PolygonMode de::vulkan::settings::getPolygonMode() const
 	return _polygonMode;
 }
 
+uint32_t de::vulkan::settings::getFramesInFlight() const
+{
+	return _framesInFlight;
+}
+
 de::vulkan::settings& de::vulkan::settings::setSampleCount(const vk::SampleCountFlagBits sampleCount)
 {
 	const auto maxSampleCount = utils::findMaxSampleCount(renderer::get()->getPhysicalDevice());
@@ -39,3 +47,9 @@ de::vulkan::settings& de::vulkan::settings::setPolygonMode(const vk::PolygonMode
 	_polygonMode = mode;
 	return *this;
 }
+
+de::vulkan::settings& de::vulkan::settings::setFramesInFlight(uint32_t framesInFlight)
+{
+	_framesInFlight = std::clamp(framesInFlight, constants::frames::minInFlight, constants::frames::maxInFlight);
+	return *this;
+}
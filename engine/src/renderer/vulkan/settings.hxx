@@ -16,8 +16,11 @@ namespace de::vulkan
 
 		vk::PolygonMode getPolygonMode() const;
 
+		uint32_t getFramesInFlight() const;
+
 		settings& setSampleCount(const vk::SampleCountFlagBits sampleCount);
 		settings& setPolygonMode(const vk::PolygonMode mode);
+		settings& setFramesInFlight(uint32_t framesInFlight);
 
 		bool operator==(const settings& other) const
 		{
@@ -28,5 +31,7 @@ namespace de::vulkan
 		vk::SampleCountFlagBits _sampleCount{vk::SampleCountFlagBits::e1};
 
 		vk::PolygonMode _polygonMode{vk::PolygonMode::eFill};
+
+		uint32_t _framesInFlight{2};
 	};
 } // namespace de::vulkan
\ No newline at end of file
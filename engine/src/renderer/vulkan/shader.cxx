@@ -2,6 +2,7 @@
 
 #include "core/misc/file.hxx"
 
+#include "constants.hxx"
 #include "dreco.hxx"
 #include "renderer.hxx"
 
@@ -20,6 +21,16 @@ std::vector<vk::DescriptorPoolSize> de::vulkan::shader::descripted_data::getDesc
 	return poolSizes;
 }
 
+vk::DescriptorType de::vulkan::shader::getDescriptorType(const SpvReflectDescriptorBinding& reflBinding)
+{
+	if (reflBinding.descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+		(std::string_view(reflBinding.name) == constants::descriptors::cameraData || std::string_view(reflBinding.name) == constants::descriptors::cullData))
+	{
+		return vk::DescriptorType::eUniformBufferDynamic;
+	}
+	return static_cast<vk::DescriptorType>(reflBinding.descriptor_type);
+}
+
 de::vulkan::shader::~shader()
 {
 	destroy();
@@ -87,14 +98,19 @@ std::vector<de::vulkan::shader::descripted_data> de::vulkan::shader::getDescirpt
 		descSetData._descriptorSetLayoutBindings.resize(reflDescSet.binding_count, vk::DescriptorSetLayoutBinding());
 		for (uint8_t k = 0; k < reflDescSet.binding_count; k++)
 		{
-			const auto& reflBinding = _reflModule.descriptor_bindings[k];
+			const auto& reflBinding = *reflDescSet.bindings[k];
 			auto& binding = descSetData._descriptorSetLayoutBindings[k];
 
 			binding = vk::DescriptorSetLayoutBinding()
 						  .setBinding(reflBinding.binding)
-						  .setDescriptorType(static_cast<vk::DescriptorType>(reflBinding.descriptor_type))
+						  .setDescriptorType(getDescriptorType(reflBinding))
 						  .setDescriptorCount(reflBinding.count)
 						  .setStageFlags(static_cast<vk::ShaderStageFlagBits>(_reflModule.shader_stage));
+
+			if (std::string_view(reflBinding.name) == constants::descriptors::textures)
+			{
+				descSetData._bindless = true;
+			}
 		}
 		descSetData._descriptorSetLayoutCreateInfo.setBindings(descSetData._descriptorSetLayoutBindings);
 	}
@@ -119,14 +135,24 @@ std::vector<vk::PushConstantRange> de::vulkan::shader::getPushConstantRanges() c
 
 de::vulkan::shader::vertex_input_info de::vulkan::shader::getVertexInputInfo() const noexcept
 {
+	// built-in inputs (gl_VertexIndex, gl_InstanceIndex) are not vertex attributes
+	std::vector<const SpvReflectInterfaceVariable*> inputVars;
+	for (uint32_t i = 0; i < _reflModule.input_variable_count; ++i)
+	{
+		const auto inputVar = _reflModule.input_variables[i];
+		if (!(inputVar->decoration_flags & SPV_REFLECT_DECORATION_BUILT_IN))
+		{
+			inputVars.push_back(inputVar);
+		}
+	}
+
 	vertex_input_info out;
-	out._attributeDesc.resize(_reflModule.input_variable_count);
+	out._attributeDesc.resize(inputVars.size());
 
-	std::vector<size_t> sizes(_reflModule.input_variable_count, size_t());
+	std::vector<size_t> sizes(inputVars.size(), size_t());
 
-	for (int i = 0; i < _reflModule.input_variable_count; ++i)
+	for (const auto inputVar : inputVars)
 	{
-		const auto& inputVar = _reflModule.input_variables[i];
 		out._attributeDesc[inputVar->location] = vk::VertexInputAttributeDescription()
 													 .setBinding(0)
 													 .setLocation(inputVar->location)
@@ -137,11 +163,11 @@ de::vulkan::shader::vertex_input_info de::vulkan::shader::getVertexInputInfo() c
 	out._bindingDesc[0] = vk::VertexInputBindingDescription()
 							  .setBinding(0)
 							  .setInputRate(vk::VertexInputRate::eVertex);
-	for (int i = 0; i < _reflModule.input_variable_count; ++i)
+	for (size_t i = 0; i < inputVars.size(); ++i)
 	{
 		if (i > 0)
 			out._attributeDesc[i].offset = out._bindingDesc[0].stride;
 		out._bindingDesc[0].stride += sizes[i];
 	}
 	return out;
-}
+}
\ No newline at end of file
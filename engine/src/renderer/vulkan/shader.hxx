@@ -16,6 +16,9 @@ namespace de::vulkan
 		{
 			uint32_t _descriptorSetIndex{UINT32_MAX};
 
+			// set of bindless heap, layout and set owned by renderer
+			bool _bindless{false};
+
 			vk::DescriptorSetLayoutCreateInfo _descriptorSetLayoutCreateInfo{};
 
 			std::vector<vk::DescriptorSetLayoutBinding> _descriptorSetLayoutBindings{};
@@ -31,6 +34,9 @@ namespace de::vulkan
 
 		using shared = std::shared_ptr<shader>;
 
+		// reflected type, except per frame uniform buffers which are dynamic
+		static vk::DescriptorType getDescriptorType(const SpvReflectDescriptorBinding& reflBinding);
+
 		shader() = default;
 		shader(shader&) = delete;
 		shader(shader&&) = default;
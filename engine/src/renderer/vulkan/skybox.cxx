@@ -3,6 +3,8 @@
 #include "constants.hxx"
 #include "renderer.hxx"
 
+#include <algorithm>
+
 void de::vulkan::skybox::init()
 {
 	auto renderer = renderer::get();
@@ -22,7 +24,6 @@ void de::vulkan::skybox::init()
 
 	_matInst = skyboxMat->makeInstance();
 
-	_matInst->setBufferDependency("cameraData", &renderer->getCameraDataBuffer());
 	_matInst->setImageDependecy("cubemap", &_cubemap);
 	_matInst->updateDescriptorSets();
 
@@ -38,15 +39,20 @@ void de::vulkan::skybox::destroy()
 
 void de::vulkan::skybox::drawCmd(vk::CommandBuffer commandBuffer)
 {
-	const auto& cubeBuffer = renderer::get()->getVertIndxBufferPool().getBuffer(_boxMeshId);
+	auto renderer = renderer::get();
+	if (!renderer->getUploader().isComplete(_uploadTicket))
+		return;
+
+	const auto& cubeBuffer = renderer->getVertIndxBufferPool().getBuffer(_boxMeshId);
 
 	commandBuffer.bindVertexBuffers(0, cubeBuffer.get(), {cubeBuffer.getOffset()});
 
-	_matInst->getMaterial()->bindCmd(commandBuffer);
+	if (!_matInst->getMaterial()->bindCmd(commandBuffer))
+		return;
 	_matInst->bindCmd(commandBuffer);
 
 	commandBuffer.setDepthTestEnable(false);
-	commandBuffer.draw(_vertSize, 1, 0, 0);
+	commandBuffer.draw(_vertSize / (sizeof(float) * 3), 1, 0, 0);
 	commandBuffer.setDepthTestEnable(true);
 }
 
@@ -101,19 +107,10 @@ void de::vulkan::skybox::createBox()
 	const vk::DeviceSize size = _vertSize;
 
 	auto renderer = renderer::get();
-	auto& bpTransfer = renderer->getTransferBufferPool();
 	auto& bpVertIndx = renderer->getVertIndxBufferPool();
 
-	const auto transferBufferId = bpTransfer.makeBuffer(size);
-	auto region = bpTransfer.map(transferBufferId);
-	memcpy(region, vertices.data(), _vertSize);
-	//memcpy(reinterpret_cast<uint8_t*>(region) + _indexOffset, indices.data(), _indxSize);
-	bpTransfer.unmap(transferBufferId);
-
 	_boxMeshId = bpVertIndx.makeBuffer(size);
+	const auto boxTicket = renderer->getUploader().uploadBuffer(bpVertIndx.getBuffer(_boxMeshId), vertices.data(), size);
 
-	const vk::BufferCopy copyRegion = vk::BufferCopy(0, 0, size);
-	de::vulkan::buffer::copyBuffer(bpTransfer.getBuffer(transferBufferId).get(), bpVertIndx.getBuffer(_boxMeshId).get(), {copyRegion});
-
-	bpTransfer.freeBuffer(transferBufferId);
+	_uploadTicket = std::max(_cubemap.getUploadTicket(), boxTicket);
 }
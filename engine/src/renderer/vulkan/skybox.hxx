@@ -4,6 +4,7 @@
 
 #include "buffer.hxx"
 #include "material_instance.hxx"
+#include "uploader.hxx"
 
 #include <vulkan/vulkan.hpp>
 
@@ -27,5 +28,8 @@ namespace de::vulkan
 		buffer::id _boxMeshId;
 
 		vk::DeviceSize _vertSize{};
+
+		// not drawn until cubemap and box uploaded
+		uploader::ticket _uploadTicket{};
 	};
 } // namespace de::vulkan
\ No newline at end of file
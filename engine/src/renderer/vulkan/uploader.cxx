@@ -0,0 +1,594 @@
+#include "uploader.hxx"
+
+#include "renderer.hxx"
+#include "utils.hxx"
+
+#include "dreco.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+static vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+void de::vulkan::uploader::init(vk::DeviceSize ringSize)
+{
+	const auto renderer{renderer::get()};
+	const auto device{renderer->getDevice()};
+
+	// buffer offset of copy into image must be multiple of texel size, 16 covers any color format
+	const auto& limits = renderer->getPhysicalDevice().getProperties().limits;
+	_alignment = std::max<vk::DeviceSize>(16, limits.optimalBufferCopyOffsetAlignment);
+
+	_ringSize = ringSize;
+	_ringHead = 0;
+	_ringUsed = 0;
+
+	_ringBuffer.create(utils::memory_property::host, vk::BufferUsageFlagBits::eTransferSrc, _ringSize);
+	_ringMemory.allocate(device.getBufferMemoryRequirements(_ringBuffer.get()), utils::memory_property::host);
+	_ringBuffer.bind(_ringMemory, 0);
+
+	_transferQueueIndex = renderer->getTransferQueueIndex();
+	_graphicsQueueIndex = renderer->getGraphicsQueueIndex();
+	_ownershipTransfer = _transferQueueIndex != _graphicsQueueIndex;
+
+	const vk::CommandPoolCreateInfo commandPoolCreateInfo = vk::CommandPoolCreateInfo()
+																.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient)
+																.setQueueFamilyIndex(_transferQueueIndex);
+	_commandPool = device.createCommandPool(commandPoolCreateInfo);
+
+	if (_ownershipTransfer)
+	{
+		const vk::CommandPoolCreateInfo acquirePoolCreateInfo = vk::CommandPoolCreateInfo()
+																	.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient)
+																	.setQueueFamilyIndex(_graphicsQueueIndex);
+		_acquireCommandPool = device.createCommandPool(acquirePoolCreateInfo);
+	}
+}
+
+void de::vulkan::uploader::destroy()
+{
+	if (!_commandPool)
+	{
+		return;
+	}
+
+	waitAll();
+
+	const auto device{renderer::get()->getDevice()};
+	for (const auto& a : _acquiresInFlight)
+	{
+		[[maybe_unused]] const auto waitResult = device.waitForFences(a._fence, true, UINT64_MAX);
+		device.destroyFence(a._fence);
+	}
+	_acquiresInFlight.clear();
+	_freeAcquireCommandBuffers.clear();
+	if (_acquireCommandPool)
+	{
+		device.destroyCommandPool(_acquireCommandPool);
+		_acquireCommandPool = nullptr;
+	}
+
+	for (auto fence : _freeFences)
+	{
+		device.destroyFence(fence);
+	}
+	_freeFences.clear();
+	_freeCommandBuffers.clear();
+
+	device.destroyCommandPool(_commandPool);
+	_commandPool = nullptr;
+
+	_ringBuffer.destroy();
+	_ringMemory.free();
+
+	if (_ringStalls)
+	{
+		DE_LOG(Info, "%s: staging ring was full %u times", __FUNCTION__, _ringStalls);
+	}
+}
+
+vk::DeviceSize de::vulkan::uploader::getStagingSize(vk::DeviceSize size) const
+{
+	return alignUp(size, _alignment);
+}
+
+void de::vulkan::uploader::beginBatch(vk::DeviceSize stagingBudget)
+{
+	assert(_budget._size == 0);
+
+	// keep batch for this budget alone, earlier uploads go with their own submit
+	submit();
+	if (stagingBudget == 0)
+	{
+		return;
+	}
+
+	getRecordingBatch();
+
+	_budget._staging = reserveStaging(stagingBudget);
+	_budget._size = stagingBudget;
+	_budget._used = 0;
+}
+
+de::vulkan::uploader::ticket de::vulkan::uploader::endBatch()
+{
+	const ticket t = _recording._ticket ? _recording._ticket : _completedTicket;
+	submit();
+	return t;
+}
+
+de::vulkan::uploader::ticket de::vulkan::uploader::uploadBuffer(const buffer_view& dst, const void* data, vk::DeviceSize size, vk::DeviceSize dstOffset)
+{
+	if (size == 0)
+	{
+		return _completedTicket;
+	}
+
+	const staging stage = reserveStaging(size);
+	std::memcpy(stage._mapped, data, size);
+	flushStaging(stage, size);
+
+	auto& b = getRecordingBatch();
+	b._bufferCopies.emplace_back(buffer_copy{stage._buffer, dst.get(), vk::BufferCopy(stage._offset, dst.getOffset() + dstOffset, size)});
+
+	return b._ticket;
+}
+
+de::vulkan::uploader::ticket de::vulkan::uploader::uploadBuffer(const buffer_view& dst, const std::vector<device_memory::map_memory_region>& regions, vk::DeviceSize size)
+{
+	if (size == 0)
+	{
+		return _completedTicket;
+	}
+
+	const staging stage = reserveStaging(size);
+	for (const auto& reg : regions)
+	{
+		std::memcpy(stage._mapped + reg.offset, reg.data, reg.size);
+	}
+	flushStaging(stage, size);
+
+	auto& b = getRecordingBatch();
+	b._bufferCopies.emplace_back(buffer_copy{stage._buffer, dst.get(), vk::BufferCopy(stage._offset, dst.getOffset(), size)});
+
+	return b._ticket;
+}
+
+de::vulkan::uploader::ticket de::vulkan::uploader::uploadImage(vk::Image image, vk::ImageAspectFlags aspect, const std::vector<device_memory::map_memory_region>& regions, vk::DeviceSize size,
+	uint32_t width, uint32_t height, uint32_t layerCount)
+{
+	if (size == 0)
+	{
+		return _completedTicket;
+	}
+
+	const staging stage = reserveStaging(size);
+	for (const auto& reg : regions)
+	{
+		std::memcpy(stage._mapped + reg.offset, reg.data, reg.size);
+	}
+	flushStaging(stage, size);
+
+	auto& b = getRecordingBatch();
+
+	const vk::ImageSubresourceRange imageSubresourceRange =
+		vk::ImageSubresourceRange()
+			.setAspectMask(aspect)
+			.setBaseMipLevel(0)
+			.setBaseArrayLayer(0)
+			.setLevelCount(1)
+			.setLayerCount(layerCount);
+
+	b._imageBarriers.emplace_back(
+		vk::ImageMemoryBarrier()
+			.setOldLayout(vk::ImageLayout::eUndefined)
+			.setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setImage(image)
+			.setSubresourceRange(imageSubresourceRange)
+			.setSrcAccessMask(vk::AccessFlagBits())
+			.setDstAccessMask(vk::AccessFlagBits::eTransferWrite));
+
+	const vk::ImageSubresourceLayers imageSubresourceLayers =
+		vk::ImageSubresourceLayers()
+			.setAspectMask(aspect)
+			.setMipLevel(0)
+			.setBaseArrayLayer(0)
+			.setLayerCount(layerCount);
+
+	const vk::BufferImageCopy copyRegion =
+		vk::BufferImageCopy()
+			.setBufferOffset(stage._offset)
+			.setBufferRowLength(0)
+			.setBufferImageHeight(0)
+			.setImageSubresource(imageSubresourceLayers)
+			.setImageOffset(vk::Offset3D(0, 0, 0))
+			.setImageExtent(vk::Extent3D(width, height, 1));
+
+	b._imageCopies.emplace_back(image_copy{stage._buffer, image, copyRegion});
+
+	return b._ticket;
+}
+
+void de::vulkan::uploader::submit()
+{
+	if (_recording._ticket == 0)
+	{
+		return;
+	}
+
+	// budget staging lifetime bound to this batch, later uploads can't use it
+	if (_budget._size)
+	{
+		flushStaging(_budget._staging, _budget._used);
+		_budget = budget();
+	}
+
+	const auto device{renderer::get()->getDevice()};
+	if (_freeCommandBuffers.empty())
+	{
+		const vk::CommandBufferAllocateInfo commandBufferAllocateInfo =
+			vk::CommandBufferAllocateInfo()
+				.setLevel(vk::CommandBufferLevel::ePrimary)
+				.setCommandBufferCount(1)
+				.setCommandPool(_commandPool);
+		_freeCommandBuffers.push_back(device.allocateCommandBuffers(commandBufferAllocateInfo)[0]);
+	}
+
+	_recording._commandBuffer = _freeCommandBuffers.back();
+	_recording._fence = makeFence();
+	_freeCommandBuffers.pop_back();
+
+	recordBatch(_recording);
+
+	const vk::SubmitInfo submitInfo =
+		vk::SubmitInfo().setCommandBuffers({1, &_recording._commandBuffer});
+	renderer::get()->getTransferQueue().submit(submitInfo, _recording._fence);
+
+	_inFlight.push_back(std::move(_recording));
+	_recording = batch();
+}
+
+void de::vulkan::uploader::tick()
+{
+	submit();
+
+	const auto device{renderer::get()->getDevice()};
+	while (!_inFlight.empty() && device.getFenceStatus(_inFlight.front()._fence) == vk::Result::eSuccess)
+	{
+		retireOldest(false);
+	}
+
+	acquireRetired();
+}
+
+void de::vulkan::uploader::wait(ticket t)
+{
+	if (isComplete(t))
+	{
+		return;
+	}
+
+	if (_recording._ticket && _recording._ticket <= t)
+	{
+		submit();
+	}
+
+	while (!_inFlight.empty() && _inFlight.front()._ticket <= t)
+	{
+		retireOldest(true);
+	}
+
+	acquireRetired();
+}
+
+void de::vulkan::uploader::waitAll()
+{
+	submit();
+	while (!_inFlight.empty())
+	{
+		retireOldest(true);
+	}
+
+	acquireRetired();
+}
+
+de::vulkan::uploader::staging de::vulkan::uploader::reserveStaging(vk::DeviceSize size)
+{
+	if (_budget._size)
+	{
+		const vk::DeviceSize offset = alignUp(_budget._staging._offset + _budget._used, _alignment) - _budget._staging._offset;
+		if (offset + size <= _budget._size)
+		{
+			_budget._used = offset + size;
+
+			staging stage = _budget._staging;
+			stage._offset += offset;
+			stage._mapped += offset;
+			stage._budgeted = true;
+			return stage;
+		}
+		DE_LOG(Error, "%s: upload of %llu bytes exceeds batch staging budget", __FUNCTION__, static_cast<unsigned long long>(size));
+	}
+
+	// big uploads would stall the ring for too long, give them own staging buffer released with batch
+	if (size > _ringSize / 2)
+	{
+		auto& bpTransfer = renderer::get()->getTransferBufferPool();
+		const auto id = bpTransfer.makeBuffer(size);
+		_recording._dedicatedStaging.push_back(id);
+
+		const auto& view = bpTransfer.getBuffer(id);
+		return staging{view.get(), view.getOffset(), reinterpret_cast<uint8_t*>(bpTransfer.map(id)), id};
+	}
+
+	vk::DeviceSize offset{};
+	while (!tryReserveRing(size, offset))
+	{
+		if (_inFlight.empty())
+		{
+			submit();
+		}
+		assert(!_inFlight.empty());
+
+		++_ringStalls;
+		DE_LOG(Verbose, "%s: staging ring full, waiting for upload %llu", __FUNCTION__, static_cast<unsigned long long>(_inFlight.front()._ticket));
+		retireOldest(true);
+	}
+
+	return staging{_ringBuffer.get(), offset, reinterpret_cast<uint8_t*>(_ringMemory.getMapped()) + offset};
+}
+
+bool de::vulkan::uploader::tryReserveRing(vk::DeviceSize size, vk::DeviceSize& outOffset)
+{
+	const vk::DeviceSize aligned = alignUp(_ringHead, _alignment);
+
+	vk::DeviceSize offset = aligned;
+	vk::DeviceSize consumed = aligned + size - _ringHead;
+	if (aligned + size > _ringSize)
+	{
+		// no room till the end, wrap and waste the rest
+		offset = 0;
+		consumed = _ringSize - _ringHead + size;
+	}
+
+	// batches retire in order, so free space is always single range right after head
+	if (_ringUsed + consumed > _ringSize)
+	{
+		return false;
+	}
+
+	_ringHead = offset + size;
+	_ringUsed += consumed;
+	_recording._ringConsumed += consumed;
+
+	outOffset = offset;
+	return true;
+}
+
+void de::vulkan::uploader::flushStaging(const staging& stage, vk::DeviceSize size)
+{
+	// budget staging flushed once on submit
+	if (stage._budgeted)
+	{
+		return;
+	}
+
+	if (stage._dedicatedId != std::numeric_limits<buffer::id>::max())
+	{
+		renderer::get()->getTransferBufferPool().flush(stage._dedicatedId);
+	}
+	else
+	{
+		_ringMemory.flush(stage._offset, size);
+	}
+}
+
+de::vulkan::uploader::batch& de::vulkan::uploader::getRecordingBatch()
+{
+	if (_recording._ticket == 0)
+	{
+		_recording._ticket = _nextTicket++;
+	}
+	return _recording;
+}
+
+void de::vulkan::uploader::recordBatch(batch& b)
+{
+	const auto commandBuffer = b._commandBuffer;
+	commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+	// single barrier ahead of all copies: staging may overwrite resources still read by previously submitted frames,
+	// and every image moves to transfer layout
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, b._imageBarriers);
+
+	// consecutive copies between same buffers merged into one command, unless destination ranges overlap
+	std::vector<vk::BufferCopy> regions;
+	for (size_t i = 0; i < b._bufferCopies.size(); ++i)
+	{
+		const auto& copy = b._bufferCopies[i];
+
+		const bool overlaps = std::any_of(regions.begin(), regions.end(), [&copy](const vk::BufferCopy& r)
+			{ return copy._region.dstOffset < r.dstOffset + r.size && r.dstOffset < copy._region.dstOffset + copy._region.size; });
+		if (overlaps)
+		{
+			commandBuffer.copyBuffer(copy._src, copy._dst, regions);
+			regions.clear();
+
+			const vk::MemoryBarrier memoryBarrier =
+				vk::MemoryBarrier()
+					.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+					.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, memoryBarrier, {}, {});
+		}
+
+		regions.push_back(copy._region);
+
+		const bool last = i + 1 == b._bufferCopies.size();
+		if (last || b._bufferCopies[i + 1]._src != copy._src || b._bufferCopies[i + 1]._dst != copy._dst)
+		{
+			commandBuffer.copyBuffer(copy._src, copy._dst, regions);
+			regions.clear();
+		}
+	}
+
+	for (const auto& copy : b._imageCopies)
+	{
+		commandBuffer.copyBufferToImage(copy._src, copy._dst, vk::ImageLayout::eTransferDstOptimal, copy._region);
+	}
+
+	// and single barrier after: copies visible to every command submitted later, images ready for sampling
+	for (auto& barrier : b._imageBarriers)
+	{
+		barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+			.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+			.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+	}
+
+	if (!_ownershipTransfer)
+	{
+		const vk::MemoryBarrier memoryBarrier =
+			vk::MemoryBarrier()
+				.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+				.setDstAccessMask(vk::AccessFlagBits::eMemoryRead);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, memoryBarrier, {}, b._imageBarriers);
+	}
+	else
+	{
+		// release every written range and image to graphics family, matching acquire recorded after batch done
+		std::vector<vk::BufferMemoryBarrier> releaseBufferBarriers;
+		releaseBufferBarriers.reserve(b._bufferCopies.size());
+		for (const auto& copy : b._bufferCopies)
+		{
+			const auto barrier =
+				vk::BufferMemoryBarrier()
+					.setSrcQueueFamilyIndex(_transferQueueIndex)
+					.setDstQueueFamilyIndex(_graphicsQueueIndex)
+					.setBuffer(copy._dst)
+					.setOffset(copy._region.dstOffset)
+					.setSize(copy._region.size);
+
+			releaseBufferBarriers.push_back(vk::BufferMemoryBarrier(barrier).setSrcAccessMask(vk::AccessFlagBits::eTransferWrite));
+			b._acquireBufferBarriers.push_back(vk::BufferMemoryBarrier(barrier).setDstAccessMask(vk::AccessFlagBits::eMemoryRead));
+		}
+
+		for (auto& barrier : b._imageBarriers)
+		{
+			barrier.setSrcQueueFamilyIndex(_transferQueueIndex)
+				.setDstQueueFamilyIndex(_graphicsQueueIndex);
+			b._acquireImageBarriers.push_back(vk::ImageMemoryBarrier(barrier).setSrcAccessMask(vk::AccessFlags()));
+			barrier.setDstAccessMask(vk::AccessFlags());
+		}
+
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, releaseBufferBarriers, b._imageBarriers);
+	}
+
+	commandBuffer.end();
+
+	b._bufferCopies.clear();
+	b._imageCopies.clear();
+	b._imageBarriers.clear();
+}
+
+void de::vulkan::uploader::retireOldest(bool wait)
+{
+	const auto renderer{renderer::get()};
+	const auto device{renderer->getDevice()};
+
+	batch b = std::move(_inFlight.front());
+	_inFlight.pop_front();
+
+	if (wait)
+	{
+		[[maybe_unused]] const auto waitResult = device.waitForFences(b._fence, true, UINT64_MAX);
+	}
+
+	device.resetFences(b._fence);
+	b._commandBuffer.reset();
+	_freeFences.push_back(b._fence);
+	_freeCommandBuffers.push_back(b._commandBuffer);
+
+	_ringUsed -= b._ringConsumed;
+	if (_ringUsed == 0)
+	{
+		_ringHead = 0;
+	}
+
+	for (const auto id : b._dedicatedStaging)
+	{
+		renderer->getTransferBufferPool().freeBuffer(id);
+	}
+
+	_acquireBufferBarriers.insert(_acquireBufferBarriers.end(), b._acquireBufferBarriers.begin(), b._acquireBufferBarriers.end());
+	_acquireImageBarriers.insert(_acquireImageBarriers.end(), b._acquireImageBarriers.begin(), b._acquireImageBarriers.end());
+
+	_retiredTicket = b._ticket;
+}
+
+void de::vulkan::uploader::acquireRetired()
+{
+	if (_acquireBufferBarriers.empty() && _acquireImageBarriers.empty())
+	{
+		_completedTicket = _retiredTicket;
+		return;
+	}
+
+	const auto renderer{renderer::get()};
+	const auto device{renderer->getDevice()};
+
+	while (!_acquiresInFlight.empty() && device.getFenceStatus(_acquiresInFlight.front()._fence) == vk::Result::eSuccess)
+	{
+		const auto a = _acquiresInFlight.front();
+		_acquiresInFlight.pop_front();
+
+		device.resetFences(a._fence);
+		a._commandBuffer.reset();
+		_freeFences.push_back(a._fence);
+		_freeAcquireCommandBuffers.push_back(a._commandBuffer);
+	}
+
+	if (_freeAcquireCommandBuffers.empty())
+	{
+		const vk::CommandBufferAllocateInfo commandBufferAllocateInfo =
+			vk::CommandBufferAllocateInfo()
+				.setLevel(vk::CommandBufferLevel::ePrimary)
+				.setCommandBufferCount(1)
+				.setCommandPool(_acquireCommandPool);
+		_freeAcquireCommandBuffers.push_back(device.allocateCommandBuffers(commandBufferAllocateInfo)[0]);
+	}
+
+	acquire a{_freeAcquireCommandBuffers.back(), makeFence()};
+	_freeAcquireCommandBuffers.pop_back();
+
+	// batches already done on transfer queue, so host fence wait orders this submit after release
+	a._commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+	a._commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, {}, _acquireBufferBarriers, _acquireImageBarriers);
+	a._commandBuffer.end();
+
+	const vk::SubmitInfo submitInfo =
+		vk::SubmitInfo().setCommandBuffers({1, &a._commandBuffer});
+	renderer->getGraphicsQueue().submit(submitInfo, a._fence);
+
+	_acquiresInFlight.push_back(a);
+	_acquireBufferBarriers.clear();
+	_acquireImageBarriers.clear();
+
+	_completedTicket = _retiredTicket;
+}
+
+vk::Fence de::vulkan::uploader::makeFence()
+{
+	if (_freeFences.empty())
+	{
+		return renderer::get()->getDevice().createFence(vk::FenceCreateInfo());
+	}
+	const auto fence = _freeFences.back();
+	_freeFences.pop_back();
+	return fence;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include "buffer.hxx"
+#include "device_memory.hxx"
+
+#include <deque>
+#include <limits>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace de::vulkan
+{
+	// records transfers into per tick command buffer and copies data through persistently mapped staging ring.
+	// ring space and command buffers recycled when fence of submitted batch signaled, so cpu never waits for queue idle.
+	// with dedicated transfer queue family, resources released by transfer queue and acquired by graphics queue once batch done
+	class uploader final
+	{
+	public:
+		// identifies batch upload was recorded to, zero is always complete
+		using ticket = uint64_t;
+
+		uploader() = default;
+		uploader(const uploader&) = delete;
+		uploader(uploader&&) = delete;
+		~uploader() { destroy(); };
+
+		void init(vk::DeviceSize ringSize);
+
+		void destroy();
+
+		// staging taken by upload of that size, use to sum budget for beginBatch
+		vk::DeviceSize getStagingSize(vk::DeviceSize size) const;
+
+		// reserve staging for several uploads at once, they are recorded to single batch submitted with endBatch
+		void beginBatch(vk::DeviceSize stagingBudget);
+
+		ticket endBatch();
+
+		ticket uploadBuffer(const buffer_view& dst, const void* data, vk::DeviceSize size, vk::DeviceSize dstOffset = 0);
+
+		// regions offsets relative to dst buffer view
+		ticket uploadBuffer(const buffer_view& dst, const std::vector<device_memory::map_memory_region>& regions, vk::DeviceSize size);
+
+		// tightly packed layers, regions offsets relative to first layer. Image ends in shader read only layout
+		ticket uploadImage(vk::Image image, vk::ImageAspectFlags aspect, const std::vector<device_memory::map_memory_region>& regions, vk::DeviceSize size,
+			uint32_t width, uint32_t height, uint32_t layerCount = 1);
+
+		// submit recorded uploads, doesn't wait
+		void submit();
+
+		// submit recorded uploads and retire finished batches
+		void tick();
+
+		// complete uploads could be used by graphics queue submissions made after this moment
+		bool isComplete(ticket t) const { return t <= _completedTicket; };
+
+		// blocks only if batch of the ticket still executing
+		void wait(ticket t);
+
+		void waitAll();
+
+	private:
+		struct staging
+		{
+			vk::Buffer _buffer;
+			vk::DeviceSize _offset{};
+			uint8_t* _mapped{nullptr};
+
+			// transfer pool buffer when staging not in the ring
+			buffer::id _dedicatedId{std::numeric_limits<buffer::id>::max()};
+
+			// sub-range of batch budget, flushed together with it
+			bool _budgeted{false};
+		};
+
+		struct buffer_copy
+		{
+			vk::Buffer _src;
+			vk::Buffer _dst;
+			vk::BufferCopy _region;
+		};
+
+		struct image_copy
+		{
+			vk::Buffer _src;
+			vk::Image _dst;
+			vk::BufferImageCopy _region;
+		};
+
+		// copies and barriers collected while batch open and recorded on submit, so barriers batched
+		struct batch
+		{
+			ticket _ticket{};
+			vk::CommandBuffer _commandBuffer;
+			vk::Fence _fence;
+			vk::DeviceSize _ringConsumed{};
+			std::vector<buffer::id> _dedicatedStaging;
+
+			std::vector<buffer_copy> _bufferCopies;
+			std::vector<image_copy> _imageCopies;
+			std::vector<vk::ImageMemoryBarrier> _imageBarriers;
+
+			// graphics queue side of ownership transfer, recorded once batch done
+			std::vector<vk::BufferMemoryBarrier> _acquireBufferBarriers;
+			std::vector<vk::ImageMemoryBarrier> _acquireImageBarriers;
+		};
+
+		struct acquire
+		{
+			vk::CommandBuffer _commandBuffer;
+			vk::Fence _fence;
+		};
+
+		struct budget
+		{
+			staging _staging;
+			vk::DeviceSize _size{};
+			vk::DeviceSize _used{};
+		};
+
+		staging reserveStaging(vk::DeviceSize size);
+
+		bool tryReserveRing(vk::DeviceSize size, vk::DeviceSize& outOffset);
+
+		void flushStaging(const staging& stage, vk::DeviceSize size);
+
+		batch& getRecordingBatch();
+
+		void recordBatch(batch& b);
+
+		void retireOldest(bool wait);
+
+		// submit acquire barriers of retired batches to graphics queue, after that they are complete
+		void acquireRetired();
+
+		vk::Fence makeFence();
+
+		buffer _ringBuffer;
+		device_memory _ringMemory;
+		vk::DeviceSize _ringSize{};
+		vk::DeviceSize _ringHead{};
+		vk::DeviceSize _ringUsed{};
+		vk::DeviceSize _alignment{16};
+
+		budget _budget;
+
+		vk::CommandPool _commandPool;
+		std::vector<vk::CommandBuffer> _freeCommandBuffers;
+		std::vector<vk::Fence> _freeFences;
+
+		bool _ownershipTransfer{false};
+		uint32_t _transferQueueIndex{};
+		uint32_t _graphicsQueueIndex{};
+
+		vk::CommandPool _acquireCommandPool;
+		std::vector<vk::CommandBuffer> _freeAcquireCommandBuffers;
+		std::deque<acquire> _acquiresInFlight;
+		std::vector<vk::BufferMemoryBarrier> _acquireBufferBarriers;
+		std::vector<vk::ImageMemoryBarrier> _acquireImageBarriers;
+
+		batch _recording;
+		std::deque<batch> _inFlight;
+
+		ticket _nextTicket{1};
+		ticket _retiredTicket{};
+		ticket _completedTicket{};
+
+		uint32_t _ringStalls{};
+	};
+} // namespace de::vulkan
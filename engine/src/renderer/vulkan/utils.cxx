@@ -6,7 +6,8 @@ vk::Format de::vulkan::utils::findSupportedDepthFormat(const vk::PhysicalDevice
 {
 	constexpr auto formatCandidates = std::array{vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint};
 	const auto imageTiling = vk::ImageTiling::eOptimal;
-	const auto formatFeatureFlags = vk::FormatFeatureFlagBits::eDepthStencilAttachment;
+	// depth also sampled to build hi-z pyramid
+	const auto formatFeatureFlags = vk::FormatFeatureFlagBits::eDepthStencilAttachment | vk::FormatFeatureFlagBits::eSampledImage;
 
 	for (const auto format : formatCandidates)
 	{
@@ -3,6 +3,7 @@
 #include "renderer.hxx"
 #include "utils.hxx"
 
+#include <algorithm>
 #include <thread>
 
 void de::vulkan::view::init(vk::SurfaceKHR surface, uint32_t viewIndex)
@@ -22,14 +23,12 @@ void de::vulkan::view::init(vk::SurfaceKHR surface, uint32_t viewIndex)
 
 	createImageViews(device);
 
-	createImageCommandBuffers(device, renderer->getTransferCommandPool());
-
 	_depthImage.create(viewIndex);
 	_msaaImage.create(viewIndex);
 
 	createRenderPass(device);
 	createFramebuffers(device);
-	createFences(device);
+	createFrames(device);
 	createSemaphores(device);
 }
 
@@ -53,6 +52,7 @@ void de::vulkan::view::recreateSwapchain()
 	_msaaImage.recreate();
 
 	createFramebuffers(device);
+	createSemaphores(device);
 }
 
 void de::vulkan::view::destroy()
@@ -62,17 +62,10 @@ void de::vulkan::view::destroy()
 	auto physicalDevice = renderer->getPhysicalDevice();
 	auto device = renderer->getDevice();
 
-	[[maybe_unused]] const auto waitResult = device.waitForFences(_submitQueueFences, true, UINT32_MAX);
-	for (auto& fence : _submitQueueFences)
-	{
-		device.destroyFence(fence);
-	}
+	destroyFrames(device);
 
 	cleanupSwapchain(device, _swapchain);
 
-	device.destroySemaphore(_semaphoreImageAvailable);
-	device.destroySemaphore(_semaphoreRenderFinished);
-
 	_depthImage.destroy();
 	_msaaImage.destroy();
 
@@ -100,10 +93,19 @@ void de::vulkan::view::applySettings(settings&& newSettings)
 {
 	if (_settings != newSettings)
 	{
+		const bool framesChanged = _settings.getFramesInFlight() != newSettings.getFramesInFlight();
+
 		_settings = newSettings;
 
 		recreateSwapchain();
 
+		if (framesChanged)
+		{
+			auto device = renderer::get()->getDevice();
+			destroyFrames(device);
+			createFrames(device);
+		}
+
 		auto& mats = renderer::get()->getMaterials();
 		for (auto& [name, mat] : mats)
 		{
@@ -117,10 +119,16 @@ uint32_t de::vulkan::view::acquireNextImageIndex()
 	const auto renderer = renderer::get();
 	auto device = renderer->getDevice();
 
+	// the only cpu wait of the frame, returns immediately unless gpu behind by all frames in flight
+	const auto& currentFrame = _frames[_frameIndex];
+	const vk::Result waitFencesResult = device.waitForFences(currentFrame._fence, true, UINT64_MAX);
+	if (waitFencesResult == vk::Result::eTimeout)
+		return UINT32_MAX;
+
 	vk::ResultValue<uint32_t> aquireNextImageResult = vk::ResultValue<uint32_t>(vk::Result{}, UINT32_MAX);
 	try
 	{
-		aquireNextImageResult = device.acquireNextImageKHR(_swapchain, UINT32_MAX, _semaphoreImageAvailable, nullptr);
+		aquireNextImageResult = device.acquireNextImageKHR(_swapchain, UINT64_MAX, currentFrame._imageAvailable, nullptr);
 	}
 	catch (vk::OutOfDateKHRError outOfDateKHRError)
 	{
@@ -140,23 +148,29 @@ uint32_t de::vulkan::view::acquireNextImageIndex()
 	return aquireNextImageResult.value;
 }
 
-vk::CommandBuffer de::vulkan::view::beginCommandBuffer(uint32_t imageIndex)
+vk::CommandBuffer de::vulkan::view::beginCommandBuffer()
 {
 	const auto renderer = renderer::get();
 	auto device = renderer->getDevice();
 
-	const std::array<vk::Fence, 1> waitFences{_submitQueueFences[imageIndex]};
-	const vk::Result waitFencesResult = device.waitForFences(waitFences, true, UINT32_MAX);
-	if (waitFencesResult == vk::Result::eTimeout)
-		return nullptr;
-
-	device.resetFences(waitFences);
+	// frame fence already waited in acquireNextImageIndex
+	const auto& currentFrame = _frames[_frameIndex];
+	device.resetCommandPool(currentFrame._commandPool);
+	for (auto pool : currentFrame._secondaryCommandPools)
+	{
+		device.resetCommandPool(pool);
+	}
 
-	vk::CommandBuffer commandBuffer = _imageCommandBuffers[imageIndex];
+	vk::CommandBuffer commandBuffer = currentFrame._commandBuffer;
 
 	const vk::CommandBufferBeginInfo commandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 	commandBuffer.begin(commandBufferBeginInfo);
 
+	return commandBuffer;
+}
+
+void de::vulkan::view::beginRenderPass(vk::CommandBuffer commandBuffer, uint32_t imageIndex)
+{
 	std::array<vk::ClearValue, 2> clearValues;
 	clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{0.0F, 0.0F, 0.0F, 1.0F});
 	clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0F, 0U);
@@ -168,24 +182,60 @@ vk::CommandBuffer de::vulkan::view::beginCommandBuffer(uint32_t imageIndex)
 			.setRenderArea(vk::Rect2D(vk::Offset2D(0, 0), _currentExtent))
 			.setClearValues(clearValues);
 
-	commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+	commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+}
+
+vk::CommandBuffer de::vulkan::view::beginSecondaryCommandBuffer(uint32_t job, uint32_t imageIndex)
+{
+	vk::CommandBuffer commandBuffer = _frames[_frameIndex]._secondaryCommandBuffers[job];
+
+	const vk::CommandBufferInheritanceInfo inheritanceInfo =
+		vk::CommandBufferInheritanceInfo()
+			.setRenderPass(_renderPass)
+			.setSubpass(0)
+			.setFramebuffer(_framebuffers[imageIndex]);
+
+	const vk::CommandBufferBeginInfo commandBufferBeginInfo =
+		vk::CommandBufferBeginInfo()
+			.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue)
+			.setPInheritanceInfo(&inheritanceInfo);
+	commandBuffer.begin(commandBufferBeginInfo);
+
+	// dynamic in every pipeline, so extent change does not rebuild them. Secondary buffers inherit no dynamic state
+	const auto viewport = vk::Viewport()
+							  .setX(0)
+							  .setY(0)
+							  .setWidth(_currentExtent.width)
+							  .setHeight(_currentExtent.height)
+							  .setMinDepth(0.0F)
+							  .setMaxDepth(1.0F);
+	commandBuffer.setViewport(0, viewport);
+	commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), _currentExtent));
 
 	return commandBuffer;
 }
 
-void de::vulkan::view::endCommandBuffer(vk::CommandBuffer commandBuffer)
+void de::vulkan::view::endRenderPass(vk::CommandBuffer commandBuffer)
 {
 	commandBuffer.endRenderPass();
+}
+
+void de::vulkan::view::endCommandBuffer(vk::CommandBuffer commandBuffer)
+{
 	commandBuffer.end();
 }
 
 void de::vulkan::view::submitCommandBuffer(uint32_t imageIndex, vk::CommandBuffer commandBuffer)
 {
 	const auto renderer = renderer::get();
+	auto device = renderer->getDevice();
 	auto graphicsQueue = renderer->getGraphicsQueue();
 
-	const std::array<vk::Semaphore, 1> submitWaitSemaphores = {_semaphoreImageAvailable};
-	const std::array<vk::Semaphore, 1> submitSignalSemaphores = {_semaphoreRenderFinished};
+	auto& currentFrame = _frames[_frameIndex];
+	_frameIndex = (_frameIndex + 1) % _frames.size();
+
+	const std::array<vk::Semaphore, 1> submitWaitSemaphores = {currentFrame._imageAvailable};
+	const std::array<vk::Semaphore, 1> submitSignalSemaphores = {_semaphoresRenderFinished[imageIndex]};
 	const std::array<vk::PipelineStageFlags, 1> submitWaitDstStages = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
 	const std::array<vk::CommandBuffer, 1> submitCommandBuffers = {commandBuffer};
 
@@ -196,7 +246,11 @@ void de::vulkan::view::submitCommandBuffer(uint32_t imageIndex, vk::CommandBuffe
 			.setWaitDstStageMask(submitWaitDstStages)
 			.setCommandBuffers(submitCommandBuffers);
 
-	graphicsQueue.submit(submitInfo, _submitQueueFences[imageIndex]);
+	// reset only when submit follows, acquire failure must leave fence signaled
+	device.resetFences(currentFrame._fence);
+	currentFrame._frameNumber = renderer->getFrameNumber();
+
+	graphicsQueue.submit(submitInfo, currentFrame._fence);
 
 	const vk::PresentInfoKHR presentInfo =
 		vk::PresentInfoKHR()
@@ -230,6 +284,22 @@ uint32_t de::vulkan::view::getImageCount() const
 	return _swapchainImageViews.size();
 }
 
+uint64_t de::vulkan::view::getCompletedFrameNumber() const
+{
+	auto device = renderer::get()->getDevice();
+
+	// frames submitted in order, so completed one is right before oldest still executing
+	uint64_t completed = renderer::get()->getFrameNumber();
+	for (const auto& f : _frames)
+	{
+		if (device.getFenceStatus(f._fence) == vk::Result::eNotReady)
+		{
+			completed = std::min(completed, f._frameNumber - 1);
+		}
+	}
+	return completed;
+}
+
 void de::vulkan::view::createSwapchain(vk::PhysicalDevice physicalDevice, vk::Device device)
 {
 	// make sure surface has right surface format
@@ -242,7 +312,6 @@ void de::vulkan::view::createSwapchain(vk::PhysicalDevice physicalDevice, vk::De
 		DE_LOG(Error, "Failed to to find preffered present mode!");
 
 	const auto sharingMode{getSharingMode()};
-	const auto queueFamilyIndexes{renderer::get()->getQueueFamilyIndices()};
 
 	const vk::SurfaceCapabilitiesKHR surfaceCapabilities = physicalDevice.getSurfaceCapabilitiesKHR(_surface);
 	const uint32_t minImageCount = surfaceCapabilities.maxImageCount >= 3 ? 3 : surfaceCapabilities.minImageCount;
@@ -257,7 +326,6 @@ void de::vulkan::view::createSwapchain(vk::PhysicalDevice physicalDevice, vk::De
 			.setImageArrayLayers(1)
 			.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment)
 			.setImageSharingMode(static_cast<vk::SharingMode>(sharingMode))
-			.setQueueFamilyIndices(queueFamilyIndexes)
 			.setPreTransform(surfaceCapabilities.currentTransform)
 			.setCompositeAlpha(vk::CompositeAlphaFlagBitsKHR::eOpaque)
 			.setPresentMode(presentMode)
@@ -275,6 +343,8 @@ void de::vulkan::view::cleanupSwapchain(vk::Device device, vk::SwapchainKHR swap
 {
 	device.waitIdle();
 
+	destroySemaphores(device);
+
 	device.destroyRenderPass(_renderPass);
 
 	for (auto frameBuffer : _framebuffers)
@@ -329,8 +399,12 @@ void de::vulkan::view::createImageViews(vk::Device device)
 
 void de::vulkan::view::createRenderPass(vk::Device device)
 {
-	const auto sampleCount = _settings.getSampleCount();
-	const bool isMultisamplingSupported = _settings.IsMultisamplingSupported();
+	_renderPass = makeRenderPass(device, getFormat(), _depthImage.getFormat(), _settings.getSampleCount());
+}
+
+vk::RenderPass de::vulkan::view::makeRenderPass(vk::Device device, vk::Format colorFormat, vk::Format depthFormat, vk::SampleCountFlagBits sampleCount)
+{
+	const bool isMultisamplingSupported = sampleCount != vk::SampleCountFlagBits::e1;
 
 	std::vector<vk::AttachmentDescription> attachmentsDescriptions;
 
@@ -338,7 +412,7 @@ void de::vulkan::view::createRenderPass(vk::Device device)
 	std::vector<vk::AttachmentReference> resolveAttachmentReferences;
 
 	attachmentsDescriptions.emplace_back() // color
-		.setFormat(getFormat())
+		.setFormat(colorFormat)
 		.setSamples(sampleCount)
 		.setLoadOp(vk::AttachmentLoadOp::eClear)
 		.setStoreOp(isMultisamplingSupported ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore)
@@ -349,20 +423,20 @@ void de::vulkan::view::createRenderPass(vk::Device device)
 	attachmentReferences.push_back(vk::AttachmentReference(0, vk::ImageLayout::eColorAttachmentOptimal));
 
 	attachmentsDescriptions.emplace_back() // depth
-		.setFormat(_depthImage.getFormat())
+		.setFormat(depthFormat)
 		.setSamples(sampleCount)
 		.setLoadOp(vk::AttachmentLoadOp::eClear)
-		.setStoreOp(vk::AttachmentStoreOp::eDontCare)
+		.setStoreOp(vk::AttachmentStoreOp::eStore)
 		.setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
 		.setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
 		.setInitialLayout(vk::ImageLayout::eUndefined)
-		.setFinalLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+		.setFinalLayout(vk::ImageLayout::eDepthStencilReadOnlyOptimal);
 	attachmentReferences.push_back(vk::AttachmentReference(1, vk::ImageLayout::eDepthStencilAttachmentOptimal));
 
 	if (isMultisamplingSupported)
 	{
 		attachmentsDescriptions.emplace_back() // color msaa
-			.setFormat(getFormat())
+			.setFormat(colorFormat)
 			.setSamples(vk::SampleCountFlagBits::e1)
 			.setLoadOp(vk::AttachmentLoadOp::eDontCare)
 			.setStoreOp(vk::AttachmentStoreOp::eDontCare)
@@ -380,22 +454,30 @@ void de::vulkan::view::createRenderPass(vk::Device device)
 			.setPDepthStencilAttachment(&attachmentReferences[1])
 			.setPResolveAttachments(resolveAttachmentReferences.data());
 
-	const vk::SubpassDependency subpassDependecy =
+	// depth of previous frame could still be read by hi-z build, depth of this one read by it after render pass
+	const std::array<vk::SubpassDependency, 2> subpassDependecies = {
 		vk::SubpassDependency()
 			.setSrcSubpass(VK_SUBPASS_EXTERNAL)
 			.setDstSubpass(0)
-			.setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests)
+			.setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eComputeShader)
 			.setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests)
 			.setSrcAccessMask(vk::AccessFlagBits(0))
-			.setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+			.setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+		vk::SubpassDependency()
+			.setSrcSubpass(0)
+			.setDstSubpass(VK_SUBPASS_EXTERNAL)
+			.setSrcStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests)
+			.setDstStageMask(vk::PipelineStageFlagBits::eComputeShader)
+			.setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+			.setDstAccessMask(vk::AccessFlagBits::eShaderRead)};
 
 	const vk::RenderPassCreateInfo renderPassCreateInfo =
 		vk::RenderPassCreateInfo()
 			.setAttachments(attachmentsDescriptions)
 			.setSubpasses({1, &subpassDescription})
-			.setDependencies({1, &subpassDependecy});
+			.setDependencies(subpassDependecies);
 
-	_renderPass = device.createRenderPass(renderPassCreateInfo);
+	return device.createRenderPass(renderPassCreateInfo);
 }
 
 void de::vulkan::view::createFramebuffers(vk::Device device)
@@ -432,28 +514,80 @@ void de::vulkan::view::createFramebuffers(vk::Device device)
 	}
 }
 
-void de::vulkan::view::createImageCommandBuffers(vk::Device device, vk::CommandPool transferCommandPool)
+void de::vulkan::view::createFrames(vk::Device device)
 {
-	const vk::CommandBufferAllocateInfo commandBufferAllocateInfo =
-		vk::CommandBufferAllocateInfo()
-			.setLevel(vk::CommandBufferLevel::ePrimary)
-			.setCommandBufferCount(getImageCount())
-			.setCommandPool(transferCommandPool);
-	_imageCommandBuffers = device.allocateCommandBuffers(commandBufferAllocateInfo);
+	const auto graphicsQueueIndex = renderer::get()->getGraphicsQueueIndex();
+	const auto recordJobCount = renderer::get()->getRecordJobCount();
+
+	_frameIndex = 0;
+	_frames.resize(_settings.getFramesInFlight());
+	for (auto& f : _frames)
+	{
+		// pool reset as whole every time frame begins
+		f._commandPool = device.createCommandPool(vk::CommandPoolCreateInfo()
+													  .setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+													  .setQueueFamilyIndex(graphicsQueueIndex));
+
+		const vk::CommandBufferAllocateInfo commandBufferAllocateInfo =
+			vk::CommandBufferAllocateInfo()
+				.setLevel(vk::CommandBufferLevel::ePrimary)
+				.setCommandBufferCount(1)
+				.setCommandPool(f._commandPool);
+		f._commandBuffer = device.allocateCommandBuffers(commandBufferAllocateInfo)[0];
+
+		f._secondaryCommandPools.resize(recordJobCount);
+		f._secondaryCommandBuffers.resize(recordJobCount);
+		for (uint32_t i = 0; i < recordJobCount; ++i)
+		{
+			f._secondaryCommandPools[i] = device.createCommandPool(vk::CommandPoolCreateInfo()
+																	   .setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+																	   .setQueueFamilyIndex(graphicsQueueIndex));
+
+			const vk::CommandBufferAllocateInfo secondaryAllocateInfo =
+				vk::CommandBufferAllocateInfo()
+					.setLevel(vk::CommandBufferLevel::eSecondary)
+					.setCommandBufferCount(1)
+					.setCommandPool(f._secondaryCommandPools[i]);
+			f._secondaryCommandBuffers[i] = device.allocateCommandBuffers(secondaryAllocateInfo)[0];
+		}
+
+		f._imageAvailable = device.createSemaphore(vk::SemaphoreCreateInfo());
+		f._fence = device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
+		f._frameNumber = 0;
+	}
 }
 
-void de::vulkan::view::createFences(vk::Device device)
+void de::vulkan::view::destroyFrames(vk::Device device)
 {
-	_submitQueueFences.resize(getImageCount());
-	for (auto& fence : _submitQueueFences)
+	for (auto& f : _frames)
 	{
-		const vk::FenceCreateInfo fenceCreateInfo(vk::FenceCreateFlagBits::eSignaled);
-		fence = device.createFence(fenceCreateInfo);
+		[[maybe_unused]] const auto waitResult = device.waitForFences(f._fence, true, UINT64_MAX);
+
+		device.destroyFence(f._fence);
+		device.destroySemaphore(f._imageAvailable);
+		device.destroyCommandPool(f._commandPool);
+		for (auto pool : f._secondaryCommandPools)
+		{
+			device.destroyCommandPool(pool);
+		}
 	}
+	_frames.clear();
 }
 
 void de::vulkan::view::createSemaphores(vk::Device device)
 {
-	_semaphoreImageAvailable = device.createSemaphore(vk::SemaphoreCreateInfo());
-	_semaphoreRenderFinished = device.createSemaphore(vk::SemaphoreCreateInfo());
+	_semaphoresRenderFinished.resize(getImageCount());
+	for (auto& semaphore : _semaphoresRenderFinished)
+	{
+		semaphore = device.createSemaphore(vk::SemaphoreCreateInfo());
+	}
 }
+
+void de::vulkan::view::destroySemaphores(vk::Device device)
+{
+	for (auto semaphore : _semaphoresRenderFinished)
+	{
+		device.destroySemaphore(semaphore);
+	}
+	_semaphoresRenderFinished.clear();
+}
\ No newline at end of file
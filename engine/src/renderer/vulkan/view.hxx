@@ -35,9 +35,19 @@ namespace de::vulkan
 		const settings& getSettings() const { return _settings; }
 		void applySettings(settings&& newSettings);
 
+		// waits until gpu done with oldest frame in flight, then acquires image for current frame
 		uint32_t acquireNextImageIndex();
 
-		vk::CommandBuffer beginCommandBuffer(uint32_t imageIndex);
+		vk::CommandBuffer beginCommandBuffer();
+
+		// render pass contents recorded to secondary command buffers
+		void beginRenderPass(vk::CommandBuffer commandBuffer, uint32_t imageIndex);
+
+		// secondary command buffer of record job, safe to call from worker executing that job
+		vk::CommandBuffer beginSecondaryCommandBuffer(uint32_t job, uint32_t imageIndex);
+
+		void endRenderPass(vk::CommandBuffer commandBuffer);
+
 		void endCommandBuffer(vk::CommandBuffer commandBuffer);
 		void submitCommandBuffer(uint32_t imageIndex, vk::CommandBuffer commandBuffer);
 
@@ -45,12 +55,24 @@ namespace de::vulkan
 		vk::Extent2D getCurrentExtent() const { return _currentExtent; };
 		vk::SurfaceKHR getSurface() const { return _surface; }
 
+		// depth ends render pass in read only layout, sampled by compute after it
+		const vk_depth_image& getDepthImage() const { return _depthImage; }
+
 		vk::SharingMode getSharingMode() const;
 
 		uint32_t getImageCount() const;
 
+		// frame recorded now, in range of settings frames in flight
+		uint32_t getFrameIndex() const { return _frameIndex; }
+
+		// renderer frame number of last submission that surely done executing on gpu
+		uint64_t getCompletedFrameNumber() const;
+
 		inline vk::Format getFormat() const { return vk::Format::eB8G8R8A8Srgb; }
 
+		// render pass every view creates, compatible with render passes of views with the same formats and sample count
+		static vk::RenderPass makeRenderPass(vk::Device device, vk::Format colorFormat, vk::Format depthFormat, vk::SampleCountFlagBits sampleCount);
+
 	private:
 		void createSwapchain(vk::PhysicalDevice physicalDevice, vk::Device device);
 
@@ -62,12 +84,30 @@ namespace de::vulkan
 
 		void createFramebuffers(vk::Device device);
 
-		void createImageCommandBuffers(vk::Device device, vk::CommandPool transferCommandPool);
+		void createFrames(vk::Device device);
 
-		void createFences(vk::Device device);
+		void destroyFrames(vk::Device device);
 
 		void createSemaphores(vk::Device device);
 
+		void destroySemaphores(vk::Device device);
+
+		// resources owned by frame reused only after its fence signaled
+		struct frame
+		{
+			vk::CommandPool _commandPool;
+			vk::CommandBuffer _commandBuffer;
+
+			// pool per record job, pool used only by thread executing the job
+			std::vector<vk::CommandPool> _secondaryCommandPools;
+			std::vector<vk::CommandBuffer> _secondaryCommandBuffers;
+			vk::Semaphore _imageAvailable;
+			vk::Fence _fence;
+
+			// renderer frame number of submission signaling the fence
+			uint64_t _frameNumber{};
+		};
+
 		uint32_t _viewIndex;
 
 		settings _settings;
@@ -85,14 +125,15 @@ namespace de::vulkan
 		vk_depth_image _depthImage;
 
 		std::vector<vk::ImageView> _swapchainImageViews;
-		std::vector<vk::CommandBuffer> _imageCommandBuffers;
 
 		vk::RenderPass _renderPass;
 
 		std::vector<vk::Framebuffer> _framebuffers;
 
-		std::vector<vk::Fence> _submitQueueFences;
+		std::vector<frame> _frames;
+		uint32_t _frameIndex{};
 
-		vk::Semaphore _semaphoreImageAvailable, _semaphoreRenderFinished;
+		// per swapchain image, presentation of image could still wait on it when frame fence already signaled
+		std::vector<vk::Semaphore> _semaphoresRenderFinished;
 	};
 } // namespace de::vulkan
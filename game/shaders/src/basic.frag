@@ -1,17 +1,17 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 inNormal;
 layout(location = 1) in vec2 inUV;
 layout(location = 2) in vec4 inColor;
+layout(location = 3) flat in uint inMaterialIndex;
 
 layout(location = 0) out vec4 outColor;
 
-layout(set = 1, binding = 0) uniform sampler2D baseColor;
-layout(set = 1, binding = 1) uniform sampler2D metallicRoughness;
-layout(set = 1, binding = 2) uniform sampler2D emissive;
-layout(set = 1, binding = 3) uniform sampler2D normal;
+// every texture of the renderer, materials refer to it by slot
+layout(set = 1, binding = 0) uniform sampler2D textures[];
 
-layout(set = 1, binding = 4) uniform readonly materialUniform
+struct Material
 {
     vec4 baseColorFactor;
     vec3 emissiveFactor;
@@ -24,17 +24,30 @@ layout(set = 1, binding = 4) uniform readonly materialUniform
     float metallicFactor;
     float roughnessFactor;
     float normalScale;
-} mat;
+
+    uint baseColorTexture;
+    uint metallicRoughnessTexture;
+    uint emissiveTexture;
+    uint normalTexture;
+};
+
+// every material of the scene, indexed by material index of drawn object
+layout(set = 2, binding = 0) readonly buffer Materials
+{
+    Material materials[];
+} materials;
 
 void main() {
+    const Material mat = materials.materials[inMaterialIndex];
+
     vec4 outColorTemp = mat.baseColorFactor + inColor.rgba;
     if (mat.hasBaseColor)
     {
-        outColorTemp = texture(baseColor, inUV) * mat.baseColorFactor;
+        outColorTemp = texture(textures[nonuniformEXT(mat.baseColorTexture)], inUV) * mat.baseColorFactor;
     }
     if (mat.hasEmissiveIndex)
     {
-        outColorTemp += texture(emissive, inUV) * vec4(mat.emissiveFactor, 1);
+        outColorTemp += texture(textures[nonuniformEXT(mat.emissiveTexture)], inUV) * vec4(mat.emissiveFactor, 1);
     }
 
     outColor = outColorTemp;
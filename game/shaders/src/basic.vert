@@ -8,22 +8,41 @@ layout(location = 3) in vec4 inColor;
 layout(location = 0) out vec3 outNormal;
 layout(location = 1) out vec2 outUV;
 layout(location = 2) out vec4 outColor;
+layout(location = 3) flat out uint outMaterialIndex;
 
+// per frame data, bound once per command buffer
 layout(set = 0, binding = 0) uniform readonly Camera 
 {
     mat4 view;
     mat4 proj;
 } cameraData;
 
-layout( push_constant ) uniform readonly constants
+struct Object
 {
     mat4 model;
-} modelData;
+    uint materialIndex;
+    uint commandIndex;
+};
+
+layout(set = 2, binding = 1) readonly buffer Objects
+{
+    Object objects[];
+} objects;
+
+// objects passed culling, indexed by firstInstance + instance of indirect draw
+layout(set = 2, binding = 2) readonly buffer VisibleObjects
+{
+    uint indices[];
+} visibleObjects;
 
 void main() {
+    const Object object = objects.objects[visibleObjects.indices[gl_InstanceIndex]];
+    const mat4 model = object.model;
+
     outUV = inUV;
     outColor = inColor;
-    outNormal = mat3(cameraData.view * modelData.model) * inNormal;
+    outMaterialIndex = object.materialIndex;
+    outNormal = mat3(cameraData.view * model) * inNormal;
 
-    gl_Position = cameraData.proj * cameraData.view * modelData.model * vec4(inPosition, 1.0);
+    gl_Position = cameraData.proj * cameraData.view * model * vec4(inPosition, 1.0);
 }
\ No newline at end of file